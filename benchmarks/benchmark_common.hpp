@@ -0,0 +1,206 @@
+#pragma once
+
+#include <asio.hpp>
+#include <drowsynetwork/Server.hpp>
+#include <drowsynetwork/Socket.hpp>
+#include <drowsynetwork/FramedSocket.hpp>
+#include <drowsynetwork/ExecutorPool.hpp>
+#include <drowsynetwork/ConnectionRegistry.hpp>
+#include <drowsynetwork/PacketBase.hpp>
+#include <drowsynetwork/Stats.hpp>
+#include <drowsynetwork/Logging.hpp>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file benchmark_common.hpp
+ * @brief Pieces shared by the benchmark programs
+ *
+ * Command line parsing, a tiny JSON writer for the results, and the
+ * in-process echo servers the benchmarks drive when no --connect target
+ * is given.
+ */
+namespace Benchmark {
+
+/**
+ * @brief --name=value command line options
+ *
+ * A bare --name counts as "1", so flags read as Get<bool>().
+ */
+class Arguments {
+public:
+    Arguments(int Count, char** Values) {
+        for (int Index = 1; Index < Count; ++Index) {
+            std::string_view Argument(Values[Index]);
+            if (!Argument.starts_with("--"))
+                continue;
+
+            Argument.remove_prefix(2);
+            const auto Separator = Argument.find('=');
+            if (Separator == std::string_view::npos) {
+                m_Values.emplace(std::string(Argument), "1");
+            } else {
+                m_Values.emplace(std::string(Argument.substr(0, Separator)), std::string(Argument.substr(Separator + 1)));
+            }
+        }
+    }
+
+    /// Whether an option was given at all
+    [[nodiscard]] bool Has(std::string_view Name) const { return m_Values.contains(std::string(Name)); }
+
+    /// Option as text, Default if missing
+    [[nodiscard]] std::string GetString(std::string_view Name, std::string_view Default) const {
+        auto It = m_Values.find(std::string(Name));
+        return It != m_Values.end() ? It->second : std::string(Default);
+    }
+
+    /// Option as a number, Default if missing or malformed
+    template<typename T>
+    [[nodiscard]] T Get(std::string_view Name, T Default) const {
+        auto It = m_Values.find(std::string(Name));
+        if (It == m_Values.end())
+            return Default;
+
+        T Value{};
+        const auto& Text = It->second;
+        const auto [End, ErrorCode] = std::from_chars(Text.data(), Text.data() + Text.size(), Value);
+        return ErrorCode == std::errc() ? Value : Default;
+    }
+
+private:
+    std::map<std::string, std::string, std::less<>> m_Values;
+};
+
+/**
+ * @brief Builds one flat-or-nested JSON object
+ *
+ * Values are written in the order they're added. Strings are expected to
+ * be plain (no escaping beyond quotes and backslashes).
+ */
+class JsonObject {
+public:
+    JsonObject& Add(std::string_view Key, std::string_view Value) {
+        std::string Escaped;
+        for (const auto Character : Value) {
+            if (Character == '"' || Character == '\\')
+                Escaped += '\\';
+            Escaped += Character;
+        }
+
+        return AddRaw(Key, std::format("\"{}\"", Escaped));
+    }
+
+    JsonObject& Add(std::string_view Key, const char* Value) { return Add(Key, std::string_view(Value)); }
+
+    JsonObject& Add(std::string_view Key, bool Value) { return AddRaw(Key, Value ? "true" : "false"); }
+
+    template<typename T> requires std::is_arithmetic_v<T>
+    JsonObject& Add(std::string_view Key, T Value) { return AddRaw(Key, std::format("{}", Value)); }
+
+    JsonObject& Add(std::string_view Key, const JsonObject& Value) { return AddRaw(Key, Value.Str()); }
+
+    /// Serialized object
+    [[nodiscard]] std::string Str() const { return "{" + m_Body + "}"; }
+
+private:
+    JsonObject& AddRaw(std::string_view Key, std::string_view Value) {
+        if (!m_Body.empty())
+            m_Body += ", ";
+        m_Body += std::format("\"{}\": {}", Key, Value);
+        return *this;
+    }
+
+    std::string m_Body;
+};
+
+/// Percentiles of a latency histogram in microseconds
+inline JsonObject LatencyToJson(const DrowsyNetwork::HistogramSnapshot& Latency) {
+    const auto Micros = [](uint64_t Nanoseconds) { return static_cast<double>(Nanoseconds) / 1000.0; };
+
+    JsonObject Result;
+    Result.Add("count", Latency.Count)
+          .Add("mean", Micros(Latency.GetMeanNs()))
+          .Add("p50", Micros(Latency.GetPercentileNs(50)))
+          .Add("p90", Micros(Latency.GetPercentileNs(90)))
+          .Add("p99", Micros(Latency.GetPercentileNs(99)))
+          .Add("p999", Micros(Latency.GetPercentileNs(99.9)))
+          .Add("max", Micros(Latency.MaxNs));
+    return Result;
+}
+
+/// Raw echo: every read is sent straight back
+class RawEchoSocket : public DrowsyNetwork::Socket {
+public:
+    using Socket::Socket;
+
+protected:
+    void OnRead(const uint8_t* Data, size_t Size) override {
+        Send(DrowsyNetwork::PacketBase<std::vector<uint8_t>>::Create(std::vector<uint8_t>(Data, Data + Size)));
+    }
+
+    void OnDisconnect() override {}
+};
+
+/// Framed echo: every message is sent back as one message
+class FramedEchoSocket : public DrowsyNetwork::FramedSocket {
+public:
+    using FramedSocket::FramedSocket;
+
+protected:
+    void OnMessage(const uint8_t* Data, size_t Size) override {
+        Send(DrowsyNetwork::PacketBase<std::vector<uint8_t>>::Create(std::vector<uint8_t>(Data, Data + Size)));
+    }
+
+    void OnDisconnect() override {}
+};
+
+/**
+ * @brief Echo server spreading its connections over an ExecutorPool
+ * @tparam SocketType RawEchoSocket or FramedEchoSocket
+ */
+template<typename SocketType>
+class EchoServer : public DrowsyNetwork::Server {
+public:
+    explicit EchoServer(DrowsyNetwork::ExecutorPool& Pool) : Server(Pool.GetExecutor(0)) {
+        SetExecutorPool(&Pool);
+    }
+
+    // OnAccept() may still be running on a pool thread - stop before m_Connections goes away
+    ~EchoServer() override { Stop(); }
+
+    /**
+     * @brief Listen on a loopback port picked by the kernel
+     * @return The port, 0 on failure
+     */
+    uint16_t ListenOnLoopback() {
+        if (!Bind(DrowsyNetwork::TcpEndpoint(asio::ip::address_v4::loopback(), 0)))
+            return 0;
+
+        StartListening();
+        return GetAcceptor(0)->local_endpoint().port();
+    }
+
+    /// Connections currently open
+    [[nodiscard]] size_t GetConnectionCount() const { return m_Connections.GetSize(); }
+
+protected:
+    void OnAccept(std::unique_ptr<DrowsyNetwork::TcpSocket>&& Socket) override {
+        Socket->set_option(asio::ip::tcp::no_delay(true));
+
+        auto& Context = GetSocketExecutor(*Socket);
+        auto Connection = std::make_shared<SocketType>(Context, std::move(Socket));
+        m_Connections.Add(Connection);
+        Connection->Setup(m_Counters);
+    }
+
+private:
+    DrowsyNetwork::ConnectionRegistry m_Connections;
+};
+
+} // namespace Benchmark
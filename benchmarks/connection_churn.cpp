@@ -0,0 +1,352 @@
+#include "benchmark_common.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#endif
+
+#if __has_include(<malloc.h>) && defined(__GLIBC__)
+#include <malloc.h>
+#define DROWSY_BENCHMARK_HEAP_STATS 1
+#endif
+
+/**
+ * @file connection_churn.cpp
+ * @brief Accept-storm and per-connection memory benchmark
+ *
+ * Two phases against an in-process echo server:
+ *
+ * 1. Churn: client threads run many concurrent sessions, each of which
+ *    connects, sends one byte, waits for the echo and closes - then starts
+ *    over. Reports connections and accepts per second and the time to
+ *    first byte (connect start until the echo arrived), which covers the
+ *    accept, OnAccept(), Socket construction and the first read.
+ *
+ * 2. Memory: holds N idle connections open and reports the heap they cost
+ *    per connection. The same is measured with plain asio sockets on both
+ *    ends, so the difference is what the library adds per connection.
+ *
+ * Options:
+ *   --client-threads=N   Churning client threads (default 2)
+ *   --server-threads=N   Server contexts (default 2)
+ *   --sessions=N         Concurrent sessions per client thread (default 64)
+ *   --duration=SECONDS   Churn time (default 5)
+ *   --hold=N             Connections held for the memory phase (default 10000, 0 = skip)
+ *   --graceful           Close with FIN instead of RST (clients then pile up TIME_WAIT)
+ *   --concurrent-accepts=N  Pending accepts per acceptor (default Server::DefaultConcurrentAccepts)
+ *   --accept-batch=N     Connections per accept wakeup, 0 = until the backlog is empty
+ *   --connect=host:port  Churn an external server instead (no memory phase)
+ *   --verbose            Log warnings and errors
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using asio::ip::tcp;
+
+/// Heap bytes in use (0 where the allocator can't tell)
+size_t GetHeapInUse() {
+#ifdef DROWSY_BENCHMARK_HEAP_STATS
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+/// Raise the open file limit as far as allowed, return it
+size_t RaiseFileLimit() {
+#if __has_include(<sys/resource.h>)
+    rlimit Limit{};
+    if (getrlimit(RLIMIT_NOFILE, &Limit) == 0) {
+        Limit.rlim_cur = Limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &Limit);
+        getrlimit(RLIMIT_NOFILE, &Limit);
+        return static_cast<size_t>(Limit.rlim_cur);
+    }
+#endif
+    return 1024;
+}
+
+/// Counters shared by every churn session
+struct ChurnResults {
+    std::atomic<bool> Running{true};
+    std::atomic<uint64_t> Completed{0};
+    std::atomic<uint64_t> Errors{0};
+    DrowsyNetwork::LatencyHistogram TimeToFirstByte;
+};
+
+/**
+ * @brief One connect - echo one byte - close loop
+ *
+ * Plain asio on purpose: the client should cost as little as possible so
+ * the server is what gets measured.
+ */
+class ChurnSession : public std::enable_shared_from_this<ChurnSession> {
+public:
+    ChurnSession(asio::io_context& Context, tcp::endpoint Target, ChurnResults& Results, bool Graceful) :
+        m_Socket(Context), m_Target(Target), m_Results(Results), m_Graceful(Graceful) {}
+
+    void Start() {
+        if (!m_Results.Running.load(std::memory_order_relaxed))
+            return;
+
+        m_Socket = tcp::socket(m_Socket.get_executor());
+        m_StartTime = Clock::now();
+        m_Socket.async_connect(m_Target, [Self = shared_from_this()](asio::error_code ErrorCode) {
+            if (ErrorCode)
+                return Self->Fail();
+
+            Self->m_Byte = 0x42;
+            asio::async_write(Self->m_Socket, asio::buffer(&Self->m_Byte, 1), [Self](asio::error_code ErrorCode, size_t) {
+                if (ErrorCode)
+                    return Self->Fail();
+
+                asio::async_read(Self->m_Socket, asio::buffer(&Self->m_Byte, 1), [Self](asio::error_code ErrorCode, size_t) {
+                    if (ErrorCode)
+                        return Self->Fail();
+
+                    Self->m_Results.TimeToFirstByte.Record(Clock::now() - Self->m_StartTime);
+                    Self->m_Results.Completed.fetch_add(1, std::memory_order_relaxed);
+                    Self->Close();
+                    Self->Start();
+                });
+            });
+        });
+    }
+
+private:
+    void Fail() {
+        m_Results.Errors.fetch_add(1, std::memory_order_relaxed);
+        Close();
+        Start();
+    }
+
+    void Close() {
+        asio::error_code ErrorCode;
+        if (!m_Graceful) {
+            // RST instead of FIN - the client port is free again right away
+            m_Socket.set_option(asio::socket_base::linger(true, 0), ErrorCode);
+        }
+        m_Socket.close(ErrorCode);
+    }
+
+    tcp::socket m_Socket;
+    tcp::endpoint m_Target;
+    ChurnResults& m_Results;
+    bool m_Graceful;
+    Clock::time_point m_StartTime;
+    uint8_t m_Byte = 0;
+};
+
+Benchmark::JsonObject RunChurn(const Benchmark::Arguments& Args, const tcp::endpoint& Target,
+    const Benchmark::EchoServer<Benchmark::RawEchoSocket>* Server) {
+    const auto ClientThreads = std::max<size_t>(Args.Get<size_t>("client-threads", 2), 1);
+    const auto Sessions = std::max<size_t>(Args.Get<size_t>("sessions", 64), 1);
+    const auto Duration = std::chrono::duration<double>(Args.Get<double>("duration", 5.0));
+    const auto Graceful = Args.Has("graceful");
+
+    ChurnResults Results;
+    std::vector<std::unique_ptr<asio::io_context>> Contexts;
+    std::vector<std::thread> Threads;
+    for (size_t Index = 0; Index < ClientThreads; ++Index) {
+        auto& Context = *Contexts.emplace_back(std::make_unique<asio::io_context>(1));
+        for (size_t Session = 0; Session < Sessions; ++Session) {
+            std::make_shared<ChurnSession>(Context, Target, Results, Graceful)->Start();
+        }
+    }
+
+    const auto AcceptedBefore = Server ? Server->GetStats().Accepted : 0;
+    const auto Start = Clock::now();
+    for (auto& Context : Contexts) {
+        Threads.emplace_back([&Context] { Context->run(); });
+    }
+
+    std::this_thread::sleep_for(Duration);
+    const auto Elapsed = std::chrono::duration<double>(Clock::now() - Start).count();
+    const auto Completed = Results.Completed.load();
+    const auto TimeToFirstByte = Results.TimeToFirstByte.Snapshot();
+    const auto Accepted = Server ? Server->GetStats().Accepted - AcceptedBefore : 0;
+
+    // Sessions stop on their next round
+    Results.Running = false;
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    Benchmark::JsonObject Result;
+    Result.Add("client_threads", ClientThreads)
+          .Add("concurrent_sessions", ClientThreads * Sessions)
+          .Add("close", Graceful ? "fin" : "rst")
+          .Add("duration_s", Elapsed)
+          .Add("connections", Completed)
+          .Add("connections_per_sec", static_cast<double>(Completed) / Elapsed)
+          .Add("errors", Results.Errors.load())
+          .Add("ttfb_us", Benchmark::LatencyToJson(TimeToFirstByte));
+
+    if (Server) {
+        Result.Add("accepts_per_sec", static_cast<double>(Accepted) / Elapsed);
+    }
+
+    return Result;
+}
+
+/// Give the server up to a few seconds to tear down the sockets of closed connections
+void WaitForServerIdle(const Benchmark::EchoServer<Benchmark::RawEchoSocket>& Server) {
+    const auto Deadline = Clock::now() + std::chrono::seconds(5);
+    while (Server.GetStats().GetOpenSockets() != 0 && Clock::now() < Deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+/**
+ * @brief Open Count connections, each echoing one byte so the server side is fully set up
+ * @return The connections, fewer if connecting failed
+ */
+std::vector<tcp::socket> OpenIdleConnections(asio::io_context& Context, const tcp::endpoint& Target, size_t Count, bool WaitForEcho) {
+    std::vector<tcp::socket> Connections;
+    Connections.reserve(Count);
+    for (size_t Index = 0; Index < Count; ++Index) {
+        tcp::socket Socket(Context);
+        asio::error_code ErrorCode;
+        Socket.connect(Target, ErrorCode);
+        if (ErrorCode)
+            break;
+
+        if (WaitForEcho) {
+            uint8_t Byte = 0x42;
+            asio::write(Socket, asio::buffer(&Byte, 1), ErrorCode);
+            asio::read(Socket, asio::buffer(&Byte, 1), ErrorCode);
+            if (ErrorCode)
+                break;
+        }
+
+        Connections.push_back(std::move(Socket));
+    }
+
+    return Connections;
+}
+
+/// Heap per connection with plain asio on both ends
+double MeasureBaselineHeap(size_t Count) {
+    asio::io_context Context(1);
+    tcp::acceptor Acceptor(Context, tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    const tcp::endpoint Target(asio::ip::address_v4::loopback(), Acceptor.local_endpoint().port());
+
+    std::vector<tcp::socket> Accepted;
+    Accepted.reserve(Count);
+    std::vector<tcp::socket> Clients;
+    Clients.reserve(Count);
+
+    const auto Before = GetHeapInUse();
+    for (size_t Index = 0; Index < Count; ++Index) {
+        tcp::socket Client(Context);
+        asio::error_code ErrorCode;
+        Client.connect(Target, ErrorCode);
+        if (ErrorCode)
+            break;
+
+        Clients.push_back(std::move(Client));
+        Accepted.push_back(Acceptor.accept(ErrorCode));
+    }
+
+    const auto After = GetHeapInUse();
+    return Clients.empty() ? 0.0 : static_cast<double>(After - Before) / static_cast<double>(Clients.size());
+}
+
+Benchmark::JsonObject RunMemory(const tcp::endpoint& Target, const Benchmark::EchoServer<Benchmark::RawEchoSocket>& Server, size_t Count) {
+    asio::io_context Context(1);
+    WaitForServerIdle(Server);
+
+    const auto OpenBefore = Server.GetConnectionCount();
+    const auto Before = GetHeapInUse();
+    auto Connections = OpenIdleConnections(Context, Target, Count, true);
+    const auto After = GetHeapInUse();
+    const auto Held = Connections.size();
+
+    const auto PerConnection = Held ? static_cast<double>(After - Before) / static_cast<double>(Held) : 0.0;
+    const auto ServerConnections = Server.GetConnectionCount() - OpenBefore;
+
+    // Close first, the baseline needs the same number of descriptors
+    Connections.clear();
+    WaitForServerIdle(Server);
+    const auto Baseline = MeasureBaselineHeap(Held);
+
+    Benchmark::JsonObject Result;
+    Result.Add("connections", Held)
+          .Add("server_connections", ServerConnections)
+          .Add("heap_bytes_per_connection", PerConnection)
+          .Add("baseline_heap_bytes_per_connection", Baseline)
+          .Add("library_bytes_per_connection", PerConnection - Baseline);
+    return Result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Benchmark::Arguments Args(argc, argv);
+    DrowsyNetwork::SetLogLevel(Args.Has("verbose") ? DrowsyNetwork::LogLevel::Warn : DrowsyNetwork::LogLevel::Off);
+
+    const auto FileLimit = RaiseFileLimit();
+
+    Benchmark::JsonObject Result;
+    Result.Add("benchmark", "churn");
+
+    if (Args.Has("connect")) {
+        const auto Target = Args.GetString("connect", "");
+        const auto Separator = Target.rfind(':');
+        asio::io_context Resolver;
+        tcp::resolver Lookup(Resolver);
+
+        asio::error_code ErrorCode;
+        auto Endpoints = Lookup.resolve(Target.substr(0, Separator), Target.substr(Separator + 1), ErrorCode);
+        if (ErrorCode || Endpoints.empty() || Separator == std::string::npos) {
+            std::println("{}", Result.Add("error", std::format("cannot resolve '{}'", Target)).Str());
+            return 1;
+        }
+
+        Result.Add("churn", RunChurn(Args, Endpoints.begin()->endpoint(), nullptr));
+        std::println("{}", Result.Str());
+        return 0;
+    }
+
+    DrowsyNetwork::ExecutorPool ServerPool(std::max<size_t>(Args.Get<size_t>("server-threads", 2), 1));
+    Benchmark::EchoServer<Benchmark::RawEchoSocket> Server(ServerPool);
+    Server.SetConcurrentAccepts(Args.Get<size_t>("concurrent-accepts", DrowsyNetwork::Server::DefaultConcurrentAccepts));
+    Server.SetAcceptBatchSize(Args.Get<size_t>("accept-batch", DrowsyNetwork::Server::DefaultAcceptBatchSize));
+    const auto Port = Server.ListenOnLoopback();
+    if (!Port) {
+        std::println("{}", Result.Add("error", "cannot listen on loopback").Str());
+        return 1;
+    }
+
+    ServerPool.Run();
+    const tcp::endpoint Target(asio::ip::address_v4::loopback(), Port);
+    Result.Add("server_threads", ServerPool.GetSize())
+          .Add("churn", RunChurn(Args, Target, &Server));
+
+    // Both ends of every held connection live in this process
+    const auto Hold = std::min(Args.Get<size_t>("hold", 10000), FileLimit > 128 ? (FileLimit - 128) / 2 : 0);
+    if (Hold) {
+#ifdef DROWSY_BENCHMARK_HEAP_STATS
+        Result.Add("memory", RunMemory(Target, Server, Hold));
+#else
+        Result.Add("memory", Benchmark::JsonObject().Add("error", "heap statistics need glibc"));
+#endif
+    }
+
+    WaitForServerIdle(Server);
+    const auto Stats = Server.GetStats();
+    Result.Add("server", Benchmark::JsonObject()
+        .Add("accepted", Stats.Accepted)
+        .Add("accept_errors", Stats.AcceptErrors)
+        .Add("sockets_opened", Stats.SocketsOpened)
+        .Add("sockets_closed", Stats.SocketsClosed));
+
+    std::println("{}", Result.Str());
+
+    ServerPool.Stop();
+    ServerPool.Join();
+    return 0;
+}
@@ -0,0 +1,335 @@
+#include "benchmark_common.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+/**
+ * @file load_generator.cpp
+ * @brief Throughput and latency benchmark for echo and framed servers
+ *
+ * Opens N connections from a pool of client threads and keeps them busy
+ * with fixed-size messages, each stamped with its send time. Every echoed
+ * message counts towards throughput and its round trip goes into a latency
+ * histogram. The result of every run is printed as one JSON line.
+ *
+ * Without --connect, an in-process server of the matching kind is started
+ * on a loopback port, so one command benchmarks the library end to end.
+ *
+ * Options:
+ *   --protocol=echo|framed|both  Server kind (both: one run each, default)
+ *   --connect=host:port          Drive an external server instead
+ *   --connections=N              Connections (default 64)
+ *   --client-threads=N           Client contexts (default 2)
+ *   --server-threads=N           In-process server contexts (default 2)
+ *   --size=BYTES                 Message size, at least 8 (default 64)
+ *   --depth=N                    Closed loop: messages in flight per connection (default 1)
+ *   --rate=N                     Open loop: total messages per second (default 0 = closed loop)
+ *   --warmup=SECONDS             Unmeasured warmup (default 1)
+ *   --duration=SECONDS           Measured time (default 5)
+ *   --verbose                    Log warnings and errors (off to keep the output plain JSON)
+ *
+ * In open-loop mode latency counts from the time a message was scheduled,
+ * not from when it was actually sent, so a stalled server can't hide its
+ * queueing delay (no coordinated omission).
+ *
+ * Every result names the I/O backend the binary was built with. To compare
+ * io_uring against epoll, build twice (-DENABLE_IO_URING=ON and OFF), run
+ * both load generators with the same options and compare the "backend"
+ * lines side by side.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig {
+    std::string Protocol;
+    size_t MessageSize = 64;
+    size_t Depth = 1;
+    double Rate = 0;
+    size_t Connections = 64;
+};
+
+/// Shared by all connections of one run
+struct LoadResults {
+    std::atomic<bool> Sending{true};
+    std::atomic<bool> Recording{false};
+    std::atomic<uint64_t> Messages{0};
+    std::atomic<uint64_t> Errors{0};
+    DrowsyNetwork::LatencyHistogram Latency;
+};
+
+/**
+ * @brief Send side and bookkeeping of one connection, independent of framing
+ */
+class LoadDriver {
+public:
+    LoadDriver(const LoadConfig& Config, LoadResults& Results) :
+        m_Config(Config), m_Results(Results) {}
+
+    /// Start sending - closed loop fills the pipeline, open loop arms the pacing timer
+    void Start(const std::shared_ptr<DrowsyNetwork::Socket>& Owner) {
+        m_Owner = Owner;
+        if (m_Config.Rate > 0) {
+            m_Interval = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(m_Config.Connections) / m_Config.Rate));
+            m_Timer = std::make_unique<asio::steady_timer>(Owner->GetExecutor());
+            m_NextSend = Clock::now();
+
+            // The timer belongs to the connection's context thread from here on
+            asio::post(Owner->GetExecutor(), [this, Self = m_Owner] {
+                if (Self.lock())
+                    Pace();
+            });
+            return;
+        }
+
+        for (size_t Index = 0; Index < m_Config.Depth; ++Index) {
+            SendMessage(Owner.get(), Clock::now());
+        }
+    }
+
+    /// One echoed message arrived
+    void OnResponse(DrowsyNetwork::Socket* Owner, const uint8_t* Data, size_t Size) {
+        if (Size != m_Config.MessageSize) {
+            m_Results.Errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        int64_t SentAt = 0;
+        std::memcpy(&SentAt, Data, sizeof(SentAt));
+
+        if (m_Results.Recording.load(std::memory_order_relaxed)) {
+            m_Results.Messages.fetch_add(1, std::memory_order_relaxed);
+            m_Results.Latency.Record(Clock::now() - Clock::time_point(Clock::duration(SentAt)));
+        }
+
+        if (m_Config.Rate <= 0)
+            SendMessage(Owner, Clock::now());
+    }
+
+    void Stop() {
+        if (m_Timer)
+            m_Timer->cancel();
+    }
+
+private:
+    void SendMessage(DrowsyNetwork::Socket* Owner, Clock::time_point SentAt) {
+        if (!m_Results.Sending.load(std::memory_order_relaxed))
+            return;
+
+        std::vector<uint8_t> Payload(m_Config.MessageSize, 0x5a);
+        const auto Stamp = static_cast<int64_t>(SentAt.time_since_epoch().count());
+        std::memcpy(Payload.data(), &Stamp, sizeof(Stamp));
+        Owner->Send(DrowsyNetwork::PacketBase<std::vector<uint8_t>>::Create(std::move(Payload)));
+    }
+
+    void Pace() {
+        auto Owner = m_Owner.lock();
+        if (!Owner || !m_Results.Sending.load(std::memory_order_relaxed))
+            return;
+
+        // Catch up on everything that was due - late sends keep their scheduled time
+        const auto Now = Clock::now();
+        while (m_NextSend <= Now) {
+            SendMessage(Owner.get(), m_NextSend);
+            m_NextSend += m_Interval;
+        }
+
+        m_Timer->expires_at(m_NextSend);
+        m_Timer->async_wait([this, Self = m_Owner](asio::error_code ErrorCode) {
+            if (!ErrorCode && Self.lock())
+                Pace();
+        });
+    }
+
+    const LoadConfig& m_Config;
+    LoadResults& m_Results;
+    std::weak_ptr<DrowsyNetwork::Socket> m_Owner;
+    std::unique_ptr<asio::steady_timer> m_Timer;
+    Clock::duration m_Interval{};
+    Clock::time_point m_NextSend;
+};
+
+/// Client for raw echo servers - the stream is cut into fixed-size messages
+class RawLoadSocket : public DrowsyNetwork::Socket {
+public:
+    RawLoadSocket(DrowsyNetwork::Executor& IOContext, std::unique_ptr<DrowsyNetwork::TcpSocket>&& Socket,
+        const LoadConfig& Config, LoadResults& Results) :
+        DrowsyNetwork::Socket(IOContext, std::move(Socket)), m_Driver(Config, Results), m_MessageSize(Config.MessageSize) {}
+
+    LoadDriver& GetDriver() { return m_Driver; }
+
+protected:
+    size_t ProcessRead(const uint8_t* Data, size_t Size) override {
+        size_t Used = 0;
+        for (; Size - Used >= m_MessageSize; Used += m_MessageSize) {
+            m_Driver.OnResponse(this, Data + Used, m_MessageSize);
+        }
+
+        return Used;
+    }
+
+    void OnRead(const uint8_t*, size_t) override {}
+
+    void OnDisconnect() override { m_Driver.Stop(); }
+
+private:
+    LoadDriver m_Driver;
+    size_t m_MessageSize;
+};
+
+/// Client for framed servers
+class FramedLoadSocket : public DrowsyNetwork::FramedSocket {
+public:
+    FramedLoadSocket(DrowsyNetwork::Executor& IOContext, std::unique_ptr<DrowsyNetwork::TcpSocket>&& Socket,
+        const LoadConfig& Config, LoadResults& Results) :
+        FramedSocket(IOContext, std::move(Socket)), m_Driver(Config, Results) {}
+
+    LoadDriver& GetDriver() { return m_Driver; }
+
+protected:
+    void OnMessage(const uint8_t* Data, size_t Size) override {
+        m_Driver.OnResponse(this, Data, Size);
+    }
+
+    void OnDisconnect() override { m_Driver.Stop(); }
+
+private:
+    LoadDriver m_Driver;
+};
+
+/**
+ * @brief Connect, load, measure and tear down
+ * @return The run's result, or an object with an "error" field
+ */
+template<typename ClientType>
+Benchmark::JsonObject RunLoad(const Benchmark::Arguments& Args, const LoadConfig& Config,
+    const DrowsyNetwork::TcpEndpoint& Target) {
+    const auto ClientThreads = std::max<size_t>(Args.Get<size_t>("client-threads", 2), 1);
+    const auto Warmup = std::chrono::duration<double>(Args.Get<double>("warmup", 1.0));
+    const auto Duration = std::chrono::duration<double>(Args.Get<double>("duration", 5.0));
+
+    LoadResults Results;
+    DrowsyNetwork::ExecutorPool Clients(ClientThreads);
+    Clients.Run();
+
+    std::vector<std::shared_ptr<ClientType>> Connections;
+    Connections.reserve(Config.Connections);
+    for (size_t Index = 0; Index < Config.Connections; ++Index) {
+        auto& Context = Clients.GetNextExecutor();
+        auto Socket = std::make_unique<DrowsyNetwork::TcpSocket>(Context);
+
+        asio::error_code ErrorCode;
+        Socket->connect(Target, ErrorCode);
+        if (ErrorCode) {
+            LOG_ERROR("Connection {} failed: {}", Index, ErrorCode.message());
+            break;
+        }
+
+        Socket->set_option(asio::ip::tcp::no_delay(true));
+        Connections.push_back(std::make_shared<ClientType>(Context, std::move(Socket), Config, Results));
+    }
+
+    for (const auto& Connection : Connections) {
+        Connection->Setup();
+        Connection->GetDriver().Start(Connection);
+    }
+
+    std::this_thread::sleep_for(Warmup);
+    const auto Start = Clock::now();
+    Results.Recording = true;
+    std::this_thread::sleep_for(Duration);
+    Results.Recording = false;
+    const auto Elapsed = std::chrono::duration<double>(Clock::now() - Start).count();
+    Results.Sending = false;
+
+    const auto Messages = Results.Messages.load();
+    const auto Megabytes = static_cast<double>(Messages * Config.MessageSize) / (1024.0 * 1024.0);
+
+    Benchmark::JsonObject Result;
+    Result.Add("benchmark", "load")
+          .Add("backend", DrowsyNetwork::IoBackendName)
+          .Add("protocol", Config.Protocol)
+          .Add("mode", Config.Rate > 0 ? "open" : "closed")
+          .Add("connections", Connections.size())
+          .Add("client_threads", ClientThreads)
+          .Add("message_size", Config.MessageSize)
+          .Add("depth", Config.Depth)
+          .Add("target_rate", Config.Rate)
+          .Add("duration_s", Elapsed)
+          .Add("messages", Messages)
+          .Add("msgs_per_sec", static_cast<double>(Messages) / Elapsed)
+          .Add("mb_per_sec", Megabytes / Elapsed)
+          .Add("errors", Results.Errors.load())
+          .Add("latency_us", Benchmark::LatencyToJson(Results.Latency.Snapshot()));
+
+    for (const auto& Connection : Connections) {
+        Connection->Disconnect();
+    }
+
+    // Let the disconnects run before the contexts stop
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Clients.Stop();
+    Clients.Join();
+    return Result;
+}
+
+template<typename ServerSocketType, typename ClientType>
+Benchmark::JsonObject RunProtocol(const Benchmark::Arguments& Args, LoadConfig Config, std::string Protocol) {
+    Config.Protocol = std::move(Protocol);
+
+    if (Args.Has("connect")) {
+        const auto Target = Args.GetString("connect", "");
+        const auto Separator = Target.rfind(':');
+        asio::io_context Resolver;
+        asio::ip::tcp::resolver Lookup(Resolver);
+
+        asio::error_code ErrorCode;
+        auto Endpoints = Lookup.resolve(Target.substr(0, Separator), Target.substr(Separator + 1), ErrorCode);
+        if (ErrorCode || Endpoints.empty() || Separator == std::string::npos)
+            return Benchmark::JsonObject().Add("error", std::format("cannot resolve '{}'", Target));
+
+        return RunLoad<ClientType>(Args, Config, Endpoints.begin()->endpoint());
+    }
+
+    DrowsyNetwork::ExecutorPool ServerPool(std::max<size_t>(Args.Get<size_t>("server-threads", 2), 1));
+    Benchmark::EchoServer<ServerSocketType> Server(ServerPool);
+    const auto Port = Server.ListenOnLoopback();
+    if (!Port)
+        return Benchmark::JsonObject().Add("error", "cannot listen on loopback");
+
+    ServerPool.Run();
+    auto Result = RunLoad<ClientType>(Args, Config, DrowsyNetwork::TcpEndpoint(asio::ip::address_v4::loopback(), Port));
+    Result.Add("server_threads", ServerPool.GetSize());
+
+    ServerPool.Stop();
+    ServerPool.Join();
+    return Result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Benchmark::Arguments Args(argc, argv);
+    // Keep stdout clean for the JSON (every closed connection logs an EOF)
+    DrowsyNetwork::SetLogLevel(Args.Has("verbose") ? DrowsyNetwork::LogLevel::Warn : DrowsyNetwork::LogLevel::Off);
+
+    LoadConfig Config;
+    Config.MessageSize = std::max<size_t>(Args.Get<size_t>("size", 64), sizeof(int64_t));
+    Config.Depth = std::max<size_t>(Args.Get<size_t>("depth", 1), 1);
+    Config.Rate = Args.Get<double>("rate", 0.0);
+    Config.Connections = std::max<size_t>(Args.Get<size_t>("connections", 64), 1);
+
+    const auto Protocol = Args.GetString("protocol", "both");
+    if (Protocol == "echo" || Protocol == "both") {
+        std::println("{}", RunProtocol<Benchmark::RawEchoSocket, RawLoadSocket>(Args, Config, "echo").Str());
+    }
+
+    if (Protocol == "framed" || Protocol == "both") {
+        std::println("{}", RunProtocol<Benchmark::FramedEchoSocket, FramedLoadSocket>(Args, Config, "framed").Str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include <benchmark/benchmark.h>
+#include <drowsynetwork/Socket.hpp>
+#include <drowsynetwork/BroadcastGroup.hpp>
+#include <drowsynetwork/PacketBase.hpp>
+#include <drowsynetwork/Logging.hpp>
+#include <array>
+#include <atomic>
+#include <thread>
+
+/**
+ * @file microbenchmarks.cpp
+ * @brief Microbenchmarks of the hot primitives: packet creation, Send and the write queue
+ *
+ * Sockets here run over an in-memory transport (MemorySocket), so what's
+ * measured is the library's own cost - strand hops, queueing, batching,
+ * reference counting - without any syscall in the way.
+ *
+ * Runs on google-benchmark, so all of its flags apply, e.g.
+ * --benchmark_filter=REGEX, --benchmark_min_time=1s,
+ * --benchmark_repetitions=N and --benchmark_format=json.
+ */
+
+namespace {
+
+using namespace DrowsyNetwork;
+
+/// Custom packet type - the GetSize()/GetBufferPointer() flavor with a fixed layout
+class FixedMessage {
+public:
+    explicit FixedMessage(uint16_t Opcode) {
+        m_Bytes[0] = static_cast<uint8_t>(Opcode >> 8);
+        m_Bytes[1] = static_cast<uint8_t>(Opcode);
+    }
+
+    [[nodiscard]] size_t GetSize() const { return m_Bytes.size(); }
+    [[nodiscard]] const uint8_t* GetBufferPointer() const { return m_Bytes.data(); }
+
+private:
+    std::array<uint8_t, 32> m_Bytes{};
+};
+
+/**
+ * @brief Socket whose writes complete in memory
+ *
+ * The socket is never connected. HandleWrite() gathers a batch exactly like
+ * the TCP path does, then instead of handing it to the kernel the write
+ * either completes on CompleteWrite() (manual mode, for driving the queue
+ * from the benchmark loop) or through a post to the strand, the way asio
+ * would report a finished write.
+ */
+class MemorySocket : public Socket {
+public:
+    static constexpr size_t ReadBufferSize = 256;
+
+    MemorySocket(Executor& Context, bool CompleteOnStrand) :
+        Socket(Context, std::make_unique<TcpSocket>(Context), ReadBufferSize), m_CompleteOnStrand(CompleteOnStrand) {
+        // No connection to wait for - call before the socket is shared with other threads
+        SetActive(true);
+    }
+
+    /// Complete the write in flight, if any (manual mode, strand only)
+    void CompleteWrite() {
+        if (std::exchange(m_HasWriteInFlight, false))
+            FinishWrite({}, m_WriteBatchBytes);
+    }
+
+    /// Whether a write is waiting for CompleteWrite()
+    [[nodiscard]] bool HasWriteInFlight() const { return m_HasWriteInFlight; }
+
+    /// Run a function on the socket's strand
+    template<typename FunctionType>
+    void Post(FunctionType&& Function) {
+        asio::post(m_Strand, std::forward<FunctionType>(Function));
+    }
+
+protected:
+    void HandleWrite() override {
+        if (!IsActive() || !HasQueuedWrites())
+            return;
+
+        PrepareWriteBatch();
+        m_WriteStartTime = StatsClock::now();
+        m_HasWriteInFlight = true;
+
+        if (m_CompleteOnStrand) {
+            Post([self = weak_from_this()] {
+                if (auto Socket = self.lock())
+                    std::static_pointer_cast<MemorySocket>(Socket)->CompleteWrite();
+            });
+        }
+    }
+
+    void OnRead(const uint8_t*, size_t) override {}
+    void OnDisconnect() override {}
+
+private:
+    bool m_CompleteOnStrand;
+    bool m_HasWriteInFlight = false;
+};
+
+/// Wait (spinning) until a socket has no more than Limit packets pending
+void WaitForPending(const Socket& Target, size_t Limit) {
+    while (Target.GetPendingWritePackets() > Limit) {
+        std::this_thread::yield();
+    }
+}
+
+// PacketBase<T>::Create
+
+void BM_CreateStringPacket(benchmark::State& State) {
+    const std::string Text(static_cast<size_t>(State.range(0)), 'x');
+    for (auto _ : State) {
+        auto Packet = PacketBase<std::string>::Create(Text);
+        benchmark::DoNotOptimize(Packet);
+    }
+    State.SetItemsProcessed(State.iterations());
+    State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_CreateStringPacket)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_CreateVectorPacket(benchmark::State& State) {
+    const std::vector<uint8_t> Bytes(static_cast<size_t>(State.range(0)), 0x42);
+    for (auto _ : State) {
+        auto Packet = PacketBase<std::vector<uint8_t>>::Create(Bytes);
+        benchmark::DoNotOptimize(Packet);
+    }
+    State.SetItemsProcessed(State.iterations());
+    State.SetBytesProcessed(State.iterations() * Bytes.size());
+}
+BENCHMARK(BM_CreateVectorPacket)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_CreateCustomPacket(benchmark::State& State) {
+    uint16_t Opcode = 0;
+    for (auto _ : State) {
+        auto Packet = PacketBase<FixedMessage>::Create(Opcode++);
+        benchmark::DoNotOptimize(Packet);
+    }
+    State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_CreateCustomPacket);
+
+// Socket::Send
+
+/// Send from inside the strand, each packet written before the next is sent
+void BM_SendOnStrand(benchmark::State& State) {
+    Executor Context(1);
+    auto Target = std::make_shared<MemorySocket>(Context, false);
+    const auto Packet = PacketBase<std::string>::Create(std::string(static_cast<size_t>(State.range(0)), 'x'));
+
+    Target->Post([&] {
+        for (auto _ : State) {
+            Target->Send(Packet);
+            Target->CompleteWrite();
+        }
+    });
+    Context.run();
+
+    State.SetItemsProcessed(State.iterations());
+    State.SetBytesProcessed(State.iterations() * Packet->size());
+}
+BENCHMARK(BM_SendOnStrand)->Arg(64)->Arg(1024);
+
+/// Send from another thread - every packet crosses over to the socket's context (timed on the wall clock, the writes run on the context's thread)
+void BM_SendOffStrand(benchmark::State& State) {
+    // Packets allowed in flight before the sender waits for the socket to catch up
+    constexpr size_t Window = 4096;
+
+    Executor Context(1);
+    auto WorkGuard = asio::make_work_guard(Context);
+    std::thread Runner([&Context] { Context.run(); });
+
+    auto Target = std::make_shared<MemorySocket>(Context, true);
+    const auto Packet = PacketBase<std::string>::Create(std::string(static_cast<size_t>(State.range(0)), 'x'));
+
+    benchmark::IterationCount Sent = 0;
+    for (auto _ : State) {
+        Target->Send(Packet);
+
+        // Count the tail too, throughput is only real once it's written
+        if (++Sent == State.max_iterations)
+            WaitForPending(*Target, 0);
+        else if (Sent % Window == 0)
+            WaitForPending(*Target, Window / 2);
+    }
+
+    WorkGuard.reset();
+    Runner.join();
+
+    State.SetItemsProcessed(State.iterations());
+    State.SetBytesProcessed(State.iterations() * Packet->size());
+}
+BENCHMARK(BM_SendOffStrand)->Arg(64)->Arg(1024)->UseRealTime();
+
+// Write queue
+
+/// Queue a burst of packets on the strand, then complete writes until the queue is empty
+void BM_WriteQueueChurn(benchmark::State& State) {
+    const auto Burst = static_cast<size_t>(State.range(0));
+    Executor Context(1);
+    auto Target = std::make_shared<MemorySocket>(Context, false);
+    const auto Packet = PacketBase<std::string>::Create(std::string(64, 'x'));
+
+    Target->Post([&] {
+        for (auto _ : State) {
+            for (size_t Index = 0; Index < Burst; ++Index) {
+                Target->Send(Packet);
+            }
+
+            while (Target->HasWriteInFlight()) {
+                Target->CompleteWrite();
+            }
+        }
+    });
+    Context.run();
+
+    State.SetItemsProcessed(State.iterations() * Burst);
+}
+BENCHMARK(BM_WriteQueueChurn)->Arg(1)->Arg(16)->Arg(256)->Arg(4096);
+
+// BroadcastGroup
+
+/// One packet to N sockets on one context, everything queued and written before the next broadcast
+void BM_BroadcastFanOut(benchmark::State& State) {
+    const auto MemberCount = static_cast<size_t>(State.range(0));
+    Executor Context(1);
+    auto WorkGuard = asio::make_work_guard(Context);
+
+    BroadcastGroup Group;
+    std::vector<std::shared_ptr<MemorySocket>> Members;
+    for (size_t Index = 0; Index < MemberCount; ++Index) {
+        Group.Add(Members.emplace_back(std::make_shared<MemorySocket>(Context, true)));
+    }
+
+    const auto Packet = PacketBase<std::string>::Create(std::string(64, 'x'));
+    for (auto _ : State) {
+        Group.Broadcast(Packet);
+        Context.poll();
+    }
+
+    State.SetItemsProcessed(State.iterations() * MemberCount);
+}
+BENCHMARK(BM_BroadcastFanOut)->Arg(1)->Arg(16)->Arg(256)->Arg(1024);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    DrowsyNetwork::SetLogLevel(DrowsyNetwork::LogLevel::Off);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,31 +1,15 @@
 #include <asio.hpp>
 #include <drowsynetwork/Server.hpp>
 #include <drowsynetwork/Socket.hpp>
+#include <drowsynetwork/ConnectionRegistry.hpp>
 #include <drowsynetwork/PacketBase.hpp>
 #include <drowsynetwork/Logging.hpp>
 #include <thread>
-#include <map>
-
-class ConnectionManager {
-public:
-    void AddSocket(uint64_t id, std::shared_ptr<DrowsyNetwork::Socket> Socket) {
-        m_sockets[id] = std::move(Socket);
-        LOG_INFO("Client {} connected. Total connections: {}", id, m_sockets.size());
-    }
-
-    void RemoveSocket(uint64_t id) {
-        m_sockets.erase(id);
-        LOG_INFO("Client {} disconnected. Total connections: {}", id, m_sockets.size());
-    }
-
-private:
-    std::map<uint64_t, std::shared_ptr<DrowsyNetwork::Socket>> m_sockets;
-};
 
 class EchoSocket : public DrowsyNetwork::Socket {
 public:
-    EchoSocket(DrowsyNetwork::Executor& ioContext, std::unique_ptr<DrowsyNetwork::TcpSocket>&& socket, ConnectionManager* manager)
-        : Socket(ioContext, std::move(socket)), m_manager(manager) {}
+    EchoSocket(DrowsyNetwork::Executor& ioContext, std::unique_ptr<DrowsyNetwork::TcpSocket>&& socket, DrowsyNetwork::ConnectionRegistry* connections)
+        : Socket(ioContext, std::move(socket)), m_connections(connections) {}
 
 protected:
     void OnRead(const uint8_t* data, size_t size) override {
@@ -36,36 +20,39 @@ protected:
     }
 
     void OnDisconnect() override {
-        m_manager->RemoveSocket(GetId());
+        // Already removed from the registry at this point
+        LOG_INFO("Client {} disconnected. Total connections: {}", GetId(), m_connections->GetSize());
     }
 
 private:
-    ConnectionManager* m_manager;
+    DrowsyNetwork::ConnectionRegistry* m_connections;
 };
 
 class EchoServer : public DrowsyNetwork::Server {
 public:
-    EchoServer(asio::io_context& ioContext, ConnectionManager* manager)
-        : Server(ioContext), m_manager(manager) {}
+    EchoServer(asio::io_context& ioContext, DrowsyNetwork::ConnectionRegistry* connections)
+        : Server(ioContext), m_connections(connections) {}
 
 private:
     void OnAccept(std::unique_ptr<DrowsyNetwork::TcpSocket>&& socket) override {
-        auto echoSocket = std::make_shared<EchoSocket>(m_IoContext, std::move(socket), m_manager);
-        echoSocket->Setup();
+        auto echoSocket = std::make_shared<EchoSocket>(m_IoContext, std::move(socket), m_connections);
+
+        // Register before Setup() - the socket unregisters itself on disconnect
+        m_connections->Add(echoSocket);
+        LOG_INFO("Client {} connected. Total connections: {}", echoSocket->GetId(), m_connections->GetSize());
 
-        // Register with connection manager
-        m_manager->AddSocket(echoSocket->GetId(), echoSocket);
+        echoSocket->Setup(m_Counters);
     }
 
 private:
-    ConnectionManager* m_manager;
+    DrowsyNetwork::ConnectionRegistry* m_connections;
 };
 
 int main() {
     try {
         asio::io_context ioContext;
-        ConnectionManager manager;
-        EchoServer server(ioContext, &manager);
+        DrowsyNetwork::ConnectionRegistry connections;
+        EchoServer server(ioContext, &connections);
 
         // Bind to localhost
         if (!server.Bind("127.0.0.1", "8080")) {
@@ -74,7 +61,7 @@ int main() {
         }
 
         server.StartListening();
-        LOG_INFO("Echo server listening on 127.0.0.1:8080");
+        LOG_INFO("Echo server listening on 127.0.0.1:8080 ({} backend)", DrowsyNetwork::IoBackendName);
         LOG_INFO("Test with: telnet 127.0.0.1 8080");
 
         // Graceful shutdown
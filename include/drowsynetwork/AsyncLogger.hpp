@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief Non-blocking logging backend behind the LOG_* macros
+ *
+ * std::println takes the stdout lock and blocks on the write, on whatever
+ * I/O thread happens to log. A burst of log lines (say, during a reconnect
+ * storm) therefore stalls every I/O thread at once. The async logger moves
+ * all of that off the I/O threads:
+ * - Every logging thread owns a lock-free single-producer ring of records.
+ * - A record holds the format string and a copy of the arguments -
+ *   formatting is deferred to a background flusher thread.
+ * - The flusher drains all rings every FlushInterval, orders the records by
+ *   time and hands them to the sink in one write.
+ * - When a thread's ring is full the message is dropped (and counted)
+ *   instead of waiting.
+ * - Repeated messages from one call site are rate limited per thread, see
+ *   SetRateLimit().
+ *
+ * It is used by Logging.hpp when built with the ASYNC_LOGGING CMake option
+ * (DROWSYNETWORK_ASYNC_LOGGING, on by default). The flusher starts on the
+ * first message and everything still queued is written at exit.
+ *
+ * Arguments are copied - strings (including const char* and string_view)
+ * become std::string, so nothing may dangle by the time the line is
+ * formatted.
+ */
+class AsyncLogger {
+public:
+    /// Receives formatted log text, one or more complete lines at a time
+    using Sink = std::function<void(std::string_view)>;
+
+    /// Records per thread ring - a thread logging faster than this per flush drops messages
+    static constexpr size_t RingCapacity = 512;
+
+    /// Argument bytes stored inline - larger argument packs are formatted on the logging thread
+    static constexpr size_t InlineArgumentSize = 192;
+
+    /// How often the flusher drains the rings
+    static constexpr std::chrono::milliseconds FlushInterval{10};
+
+    /// Default messages per call site, thread and second before repeats are suppressed
+    static constexpr uint32_t DefaultRateLimit = 100;
+
+    /**
+     * @brief Queue a log line
+     * @param Format Format string, checked at compile time
+     * @param Arguments Values to format, copied into the record
+     */
+    template<typename... Args>
+    static void Log(std::format_string<Args...> Format, Args&&... Arguments) {
+        using Stored = std::tuple<StoredType<Args>...>;
+        if constexpr (sizeof(Stored) <= InlineArgumentSize && alignof(Stored) <= alignof(std::max_align_t)) {
+            Push(Format.get(), &FormatRecord<Stored>, [&](void* Storage) {
+                ::new (Storage) Stored(Store(std::forward<Args>(Arguments))...);
+            });
+        } else {
+            // Too big to defer - format here, the flusher only copies the text
+            using Text = std::tuple<std::string>;
+            auto Line = std::format(Format, std::forward<Args>(Arguments)...);
+            Push(Format.get(), &FormatText, [&](void* Storage) {
+                ::new (Storage) Text(std::move(Line));
+            });
+        }
+    }
+
+    /**
+     * @brief Write everything queued so far before returning
+     *
+     * Call this before handing control to code that may not return, like
+     * std::abort(). Normal exits flush automatically.
+     */
+    static void Flush();
+
+    /**
+     * @brief Replace where log text goes (stdout by default)
+     * @param Output New sink, called from the flusher thread only
+     */
+    static void SetSink(Sink Output);
+
+    /**
+     * @brief Limit how often one call site may log
+     * @param MessagesPerSecond Messages per call site, thread and second (0 = unlimited)
+     *
+     * Further messages in the same second are dropped. The next message
+     * that gets through reports how many were suppressed.
+     */
+    static void SetRateLimit(uint32_t MessagesPerSecond);
+
+    /// Messages dropped so far because a thread's ring was full
+    [[nodiscard]] static uint64_t GetDroppedCount();
+
+private:
+    /// Formats a record's arguments into Out, then destroys them
+    using FormatFunction = void (*)(std::string& Out, std::string_view Format, void* Arguments);
+
+    /// Strings are owned, everything else is copied as is
+    template<typename T>
+    using StoredType = std::conditional_t<
+        std::is_convertible_v<std::decay_t<T>, std::string_view> && !std::is_same_v<std::decay_t<T>, std::nullptr_t>,
+        std::string, std::decay_t<T>>;
+
+    template<typename T>
+    static StoredType<T> Store(T&& Value) {
+        if constexpr (std::is_pointer_v<std::decay_t<T>> && std::is_same_v<StoredType<T>, std::string>) {
+            return Value ? std::string(Value) : std::string("(null)");
+        } else {
+            return StoredType<T>(std::forward<T>(Value));
+        }
+    }
+
+    template<typename Stored>
+    static void FormatRecord(std::string& Out, std::string_view Format, void* Arguments) {
+        auto& Values = *static_cast<Stored*>(Arguments);
+        std::apply([&](auto&... Elements) {
+            Out += std::vformat(Format, std::make_format_args(Elements...));
+        }, Values);
+        Values.~Stored();
+    }
+
+    static void FormatText(std::string& Out, std::string_view Format, void* Arguments);
+
+    /// Claim a slot in the calling thread's ring and let Construct fill in the arguments
+    template<typename ConstructFunction>
+    static void Push(std::string_view Format, FormatFunction Writer, ConstructFunction&& Construct) {
+        auto* Storage = Reserve(Format, Writer);
+        if (!Storage)
+            return;
+
+        Construct(Storage);
+        Commit();
+    }
+
+    /// Slot storage for the next record, nullptr if it's rate limited or the ring is full
+    static void* Reserve(std::string_view Format, FormatFunction Writer);
+
+    /// Publish the record Reserve() handed out
+    static void Commit();
+};
+
+} // namespace DrowsyNetwork
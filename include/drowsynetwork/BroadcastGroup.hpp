@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Socket.hpp"
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief A set of sockets that receive the same packets
+ *
+ * Broadcasting by calling Send() on every socket costs one post (and one
+ * packet reference) per member, all funneled through whatever lock guards
+ * your socket list. BroadcastGroup does better:
+ * - The packet is built once and the same immutable buffer is queued on
+ *   every member, so it's serialized exactly once.
+ * - Members are kept in contiguous arrays grouped by the context they run
+ *   on. A broadcast posts one handler per context, which then queues the
+ *   packet on all of that context's members in a tight loop.
+ * - Each context's member array is copy-on-write. A broadcast only takes
+ *   a reference to every array, and Add()/Remove() copy an array only
+ *   while a broadcast still holds it, so membership churn doesn't turn
+ *   into per-broadcast copies of the whole group.
+ *
+ * All methods are thread-safe.
+ *
+ * @code
+ * DrowsyNetwork::BroadcastGroup lobby;
+ *
+ * // In OnAccept / OnDisconnect
+ * lobby.Add(client);
+ * lobby.Remove(client->GetId());
+ *
+ * // Anywhere
+ * lobby.Broadcast(DrowsyNetwork::PacketBase<std::string>::Create(state));
+ * @endcode
+ */
+class BroadcastGroup {
+public:
+    BroadcastGroup() = default;
+
+    BroadcastGroup(const BroadcastGroup&) = delete;
+    BroadcastGroup& operator=(const BroadcastGroup&) = delete;
+
+    /**
+     * @brief Add a socket to the group
+     * @param Member Socket to add (ignored if already a member)
+     *
+     * The group keeps the socket alive until it's removed, so remember to
+     * call Remove() from your OnDisconnect().
+     */
+    void Add(const std::shared_ptr<Socket>& Member);
+
+    /**
+     * @brief Remove a socket from the group
+     * @param Id Socket id (see Socket::GetId())
+     * @return true if the socket was a member
+     */
+    bool Remove(uint64_t Id);
+
+    /**
+     * @brief Check membership
+     * @param Id Socket id
+     * @return true if the socket is a member
+     */
+    [[nodiscard]] bool Contains(uint64_t Id) const;
+
+    /// Number of members
+    [[nodiscard]] size_t GetSize() const;
+
+    /**
+     * @brief Send a packet to every member
+     * @tparam T Packet data type
+     * @param Packet Packet to send - shared by all members, don't modify it afterwards
+     * @param Priority Write lane to queue the packet in on every member
+     */
+    template <PacketConcept T>
+    void Broadcast(const PacketPtr<T>& Packet, SendPriority Priority = SendPriority::Realtime) {
+        Broadcast(IPacketBasePtr(Packet), Priority);
+    }
+
+    /**
+     * @brief Send a type-erased packet to every member
+     * @param Packet Packet to send - shared by all members, don't modify it afterwards
+     * @param Priority Write lane to queue the packet in on every member
+     */
+    void Broadcast(const IPacketBasePtr& Packet, SendPriority Priority = SendPriority::Realtime);
+
+private:
+    /// Members of one context, shared with the broadcasts in flight
+    using MemberList = std::vector<std::shared_ptr<Socket>>;
+
+    /// Members that run on the same context
+    struct Bucket {
+        Executor* Context;
+        std::shared_ptr<MemberList> Members; ///< Never modified while a broadcast holds it
+    };
+
+    /// Where a member lives inside m_Buckets
+    struct Location {
+        size_t Bucket;
+        size_t Index;
+    };
+
+    /**
+     * @brief Get a bucket's members for modification
+     * @param Entry Bucket to change (m_Mutex held)
+     * @return The member array, copied first if a broadcast still uses it
+     */
+    static MemberList& Modify(Bucket& Entry);
+
+    mutable std::mutex m_Mutex;                           ///< Guards everything below
+    std::vector<Bucket> m_Buckets;                        ///< Members grouped by context
+    std::unordered_map<uint64_t, Location> m_Locations;   ///< Socket id -> position in m_Buckets
+};
+
+} // namespace DrowsyNetwork
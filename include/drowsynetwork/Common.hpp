@@ -41,12 +41,44 @@ namespace DrowsyNetwork {
     template<typename T>
     using Strand = asio::strand<T>;
 
+    /**
+     * @brief Executor every Socket serializes its handlers on
+     *
+     * By default this is a strand, so a socket is safe to use even when its
+     * io_context is run by several threads. Building with the
+     * SINGLE_THREADED_SOCKETS CMake option (DROWSYNETWORK_SINGLE_THREADED)
+     * drops the strand and uses the plain context executor instead - there
+     * is nothing to serialize when exactly one thread runs each context,
+     * like with ExecutorPool. Never run a context from more than one thread
+     * in that mode.
+     */
+#ifdef DROWSYNETWORK_SINGLE_THREADED
+    using SocketExecutor = ExecutorType;
+#else
+    using SocketExecutor = Strand<ExecutorType>;
+#endif
+
     /// Mutable buffer for writing data - points to memory you can modify
     using Buffer = asio::mutable_buffer;
 
     /// Immutable buffer for reading data - points to read-only memory
     using ConstBuffer = asio::const_buffer;
 
+    /**
+     * @brief True when all I/O goes through io_uring instead of epoll
+     *
+     * Controlled by the ENABLE_IO_URING CMake option. Sockets, acceptors and
+     * timers don't change - asio submits their operations to the ring.
+     */
+#if defined(ASIO_HAS_IO_URING) && defined(ASIO_DISABLE_EPOLL)
+    inline constexpr bool UsingIoUring = true;
+#else
+    inline constexpr bool UsingIoUring = false;
+#endif
+
+    /// Name of the active I/O backend, handy for startup logs and benchmark reports
+    inline constexpr const char* IoBackendName = UsingIoUring ? "io_uring" : "epoll";
+
     /// Standardized size type for all size operations
     /// Using int64_t instead of size_t to avoid signed/unsigned comparison issues
     using SizeType = int64_t;
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Socket.hpp"
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <memory>
+#include <atomic>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief Thread-safe id -> Socket map for all live connections
+ *
+ * The usual "std::map behind one mutex" connection manager makes every
+ * connect, disconnect and lookup on every thread wait for the same lock.
+ * The registry splits the map into shards by socket id instead:
+ * - Connects and disconnects only lock the one shard they touch, so
+ *   storms on different threads rarely meet.
+ * - Lookups take a shared lock, so they never wait for each other.
+ * - The connection count is kept outside the shards and costs nothing.
+ *
+ * Sockets remove themselves automatically when they disconnect, right
+ * before OnDisconnect() is called. The registry must outlive every socket
+ * added to it (or at least their disconnects).
+ *
+ * @code
+ * DrowsyNetwork::ConnectionRegistry connections;
+ *
+ * void OnAccept(std::unique_ptr<TcpSocket>&& socket) override {
+ *     auto client = std::make_shared<MySocket>(m_IoContext, std::move(socket));
+ *     connections.Add(client);  // Before Setup()
+ *     client->Setup();
+ * }
+ *
+ * if (auto client = connections.Find(id))
+ *     client->Send(packet);
+ * @endcode
+ */
+class ConnectionRegistry {
+public:
+    /// Default number of shards - plenty to keep a few dozen threads apart
+    static constexpr size_t DefaultShardCount = 64;
+
+    /**
+     * @brief Create an empty registry
+     * @param ShardCount Number of shards, rounded up to a power of two
+     */
+    explicit ConnectionRegistry(size_t ShardCount = DefaultShardCount);
+
+    /**
+     * @brief Detaches all remaining sockets so they don't call back into a dead registry
+     */
+    ~ConnectionRegistry();
+
+    ConnectionRegistry(const ConnectionRegistry&) = delete;
+    ConnectionRegistry& operator=(const ConnectionRegistry&) = delete;
+
+    /**
+     * @brief Register a socket
+     * @param Connection Socket to add
+     * @return false if the socket is null or already registered somewhere
+     *
+     * Call this before Socket::Setup(), so the socket can't disconnect
+     * before it's registered.
+     */
+    bool Add(const std::shared_ptr<Socket>& Connection);
+
+    /**
+     * @brief Unregister a socket (done automatically on disconnect)
+     * @param Id Socket id
+     * @return true if the socket was registered
+     */
+    bool Remove(uint64_t Id);
+
+    /**
+     * @brief Look up a socket by id
+     * @param Id Socket id
+     * @return The socket, or nullptr if it's not registered
+     */
+    [[nodiscard]] std::shared_ptr<Socket> Find(uint64_t Id) const;
+
+    /// Number of registered sockets
+    [[nodiscard]] size_t GetSize() const { return m_Size.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Copy all registered sockets
+     * @return Every socket registered at the time its shard was visited
+     *
+     * Shards are copied one at a time, so this never blocks the whole
+     * registry. Use it for fan-out that shouldn't hold any lock while sending.
+     */
+    [[nodiscard]] std::vector<std::shared_ptr<Socket>> GetSnapshot() const;
+
+    /**
+     * @brief Call a function for every registered socket
+     * @param Function Called as Function(const std::shared_ptr<Socket>&)
+     *
+     * Works shard by shard on a copy, so the function may Send(), Disconnect()
+     * or even Remove() without deadlocking.
+     */
+    template<typename FunctionType>
+    void ForEach(FunctionType&& Function) const {
+        std::vector<std::shared_ptr<Socket>> Members;
+        for (size_t Index = 0; Index <= m_ShardMask; ++Index) {
+            Members.clear();
+            CopyShard(m_Shards[Index], Members);
+
+            for (const auto& Member : Members) {
+                Function(Member);
+            }
+        }
+    }
+
+private:
+    /// One slice of the map, on its own cache line so shards don't false-share
+    struct alignas(64) Shard {
+        mutable std::shared_mutex Mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<Socket>> Sockets;
+    };
+
+    Shard& GetShard(uint64_t Id) const { return m_Shards[Id & m_ShardMask]; }
+
+    static void CopyShard(const Shard& Source, std::vector<std::shared_ptr<Socket>>& Destination);
+
+    std::unique_ptr<Shard[]> m_Shards; ///< Shard array, size is a power of two
+    size_t m_ShardMask;                ///< Shard count - 1
+    std::atomic<size_t> m_Size;        ///< Registered sockets over all shards
+};
+
+} // namespace DrowsyNetwork
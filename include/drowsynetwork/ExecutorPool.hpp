@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Common.hpp"
+#include <vector>
+#include <thread>
+#include <memory>
+#include <atomic>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief A set of I/O contexts, each run by exactly one thread
+ *
+ * Instead of running many threads on one shared io_context, the pool gives
+ * every thread (usually one per core) its own context. Everything created
+ * on a context - acceptors, sockets, their strands - then stays on that
+ * thread, so completions never bounce between cores and the contexts don't
+ * share a reactor lock.
+ *
+ * There are two ways to spread connections over the pool:
+ *
+ * 1. One server per context, all bound to the same port with SO_REUSEPORT.
+ *    The kernel balances incoming connections between the acceptors.
+ * @code
+ * DrowsyNetwork::ExecutorPool pool;
+ * std::vector<std::unique_ptr<MyServer>> servers;
+ * for (size_t i = 0; i < pool.GetSize(); ++i) {
+ *     auto& server = servers.emplace_back(std::make_unique<MyServer>(pool.GetExecutor(i)));
+ *     server->SetReusePort(true);
+ *     server->Bind("0.0.0.0", "8080");
+ *     server->StartListening();
+ * }
+ * pool.Run();
+ * pool.Join();
+ * @endcode
+ *
+ * 2. A single server that hands accepted connections out round-robin,
+ *    see Server::SetExecutorPool(). Works on platforms without SO_REUSEPORT.
+ *
+ * Since every context is run by exactly one thread, the pool is a natural
+ * fit for SINGLE_THREADED_SOCKETS builds, where sockets skip their strand.
+ */
+class ExecutorPool {
+public:
+    /**
+     * @brief Create the pool's contexts (no threads are started yet)
+     * @param Size Number of contexts/threads, defaults to one per core
+     */
+    explicit ExecutorPool(size_t Size = std::thread::hardware_concurrency());
+
+    /**
+     * @brief Stops all contexts and joins the threads
+     */
+    ~ExecutorPool();
+
+    ExecutorPool(const ExecutorPool&) = delete;
+    ExecutorPool& operator=(const ExecutorPool&) = delete;
+
+    /**
+     * @brief Start one thread per context
+     * @param PinThreads Pin thread N to CPU N (Linux only, ignored elsewhere)
+     *
+     * Doesn't block. The contexts keep running, even without pending work,
+     * until Stop() is called.
+     */
+    void Run(bool PinThreads = false);
+
+    /**
+     * @brief Ask every context to stop
+     *
+     * Safe to call from any thread, including from a handler running on
+     * one of the pool's contexts.
+     */
+    void Stop();
+
+    /**
+     * @brief Wait for all threads started by Run() to finish
+     */
+    void Join();
+
+    /// Number of contexts in the pool
+    [[nodiscard]] size_t GetSize() const { return m_Executors.size(); }
+
+    /**
+     * @brief Get a specific context
+     * @param Index Zero-based context index (wraps around)
+     * @return The context
+     */
+    [[nodiscard]] Executor& GetExecutor(size_t Index);
+
+    /**
+     * @brief Get the next context in round-robin order
+     * @return The context
+     *
+     * Thread-safe, used to spread new connections over the pool.
+     */
+    [[nodiscard]] Executor& GetNextExecutor();
+
+private:
+    std::vector<std::unique_ptr<Executor>> m_Executors; ///< One context per thread
+    std::vector<asio::executor_work_guard<ExecutorType>> m_WorkGuards; ///< Keep idle contexts running
+    std::vector<std::thread> m_Threads; ///< Threads started by Run()
+    std::atomic<size_t> m_Next;         ///< Round-robin cursor
+};
+
+} // namespace DrowsyNetwork
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Socket.hpp"
+#include <vector>
+#include <span>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief View of one complete message inside the read buffer
+ *
+ * Points straight into the socket's read buffer - only valid while the
+ * OnMessages() call that received it is running.
+ */
+struct FrameView {
+    const uint8_t* Data; ///< First payload byte
+    size_t Size;         ///< Payload size in bytes
+};
+
+/**
+ * @brief Socket with built-in length-prefixed message framing
+ *
+ * Every message on the wire is a SizeType length prefix followed by the
+ * payload. FramedSocket takes care of both directions:
+ * - Reads pull in as much as is available with one read, then every
+ *   complete message in the buffer is handed to the application in place,
+ *   without copying. Partial messages simply wait for the next read.
+ * - Writes send the length prefix and payload of every queued packet in
+ *   the same gather write, so you keep sending plain packets.
+ *
+ * A message (prefix included) has to fit into the read buffer, so pass a
+ * ReadBufferSize large enough for your biggest message. Peers announcing
+ * bigger (or negative) sizes are disconnected.
+ *
+ * @code
+ * class ChatSocket : public DrowsyNetwork::FramedSocket {
+ * public:
+ *     using FramedSocket::FramedSocket;
+ *
+ * protected:
+ *     void OnMessage(const uint8_t* data, size_t size) override {
+ *         std::string message(reinterpret_cast<const char*>(data), size);
+ *         Send(DrowsyNetwork::PacketBase<std::string>::Create("Echo: " + message));
+ *     }
+ *
+ *     void OnDisconnect() override {}
+ * };
+ * @endcode
+ */
+class FramedSocket : public Socket {
+public:
+    /// Length prefix type sent in front of every message
+    using HeaderType = SizeType;
+
+    /// Size of the length prefix in bytes
+    static constexpr size_t HeaderSize = sizeof(HeaderType);
+
+    /// Packets per write - each takes two buffers, its prefix and its payload
+    static constexpr size_t MaxWriteBatchPackets = MaxWriteBuffers / 2;
+
+    /**
+     * @brief Construct a framed socket
+     * @param IOContext The ASIO I/O context for async operations
+     * @param Socket Already connected TCP socket (moved)
+     * @param ReadBufferSize Capacity of the receive buffer, bounds the message size
+     */
+    explicit FramedSocket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket,
+        size_t ReadBufferSize = ReadBuffer::DefaultCapacity);
+
+    /**
+     * @brief Construct a framed socket with read buffers from a shared pool
+     * @param IOContext The ASIO I/O context for async operations
+     * @param Socket Already connected TCP socket (moved)
+     * @param Pool Pool shared with other sockets, its block size bounds the message size
+     *
+     * A block is only held while a partial message is waiting for the rest.
+     */
+    explicit FramedSocket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket,
+        std::shared_ptr<ReadBufferPool> Pool);
+
+    ~FramedSocket() override = default;
+
+    /**
+     * @brief Get the largest payload this socket accepts
+     * @return Maximum message size in bytes (without the length prefix)
+     */
+    [[nodiscard]] size_t GetMaxMessageSize() const;
+
+protected:
+    /**
+     * @brief Handle one complete message
+     * @param Data Pointer to the message payload
+     * @param Size Payload size in bytes
+     *
+     * Called once per message by the default OnMessages(). The data points
+     * straight into the read buffer and is only valid for the duration of
+     * this call. Copy it if you need it later.
+     *
+     * Override either this or OnMessages() in your derived class. The
+     * default drops the message and logs an error the first time.
+     */
+    virtual void OnMessage(const uint8_t* Data, size_t Size);
+
+    /**
+     * @brief Handle every complete message parsed from one read
+     * @param Frames All complete messages, in arrival order
+     *
+     * Override this instead of OnMessage() when your handler can do work
+     * once per batch rather than once per message - take a lock once,
+     * group database lookups, or build a single combined response.
+     *
+     * @code
+     * void OnMessages(std::span<const DrowsyNetwork::FrameView> frames) override {
+     *     std::lock_guard lock(m_game->Mutex());
+     *     for (const auto& frame : frames)
+     *         m_game->Apply(GetId(), frame.Data, frame.Size);
+     * }
+     * @endcode
+     *
+     * The default implementation calls OnMessage() for each frame and
+     * stops early if the socket gets disconnected.
+     */
+    virtual void OnMessages(std::span<const FrameView> Frames);
+
+    /**
+     * @brief Parse every complete message out of the read buffer
+     * @return Number of bytes belonging to complete messages
+     *
+     * Collects all complete messages and hands them to OnMessages() in
+     * one call, leaving a trailing partial message in the buffer for the
+     * next read.
+     */
+    size_t ProcessRead(const uint8_t* Data, size_t Size) override;
+
+    /**
+     * @brief Build the gather write with a length prefix per packet
+     *
+     * Each packet of the batch takes two buffers (prefix and payload), so
+     * a batch holds at most MaxWriteBuffers / 2 packets.
+     */
+    void PrepareWriteBatch() override;
+
+    /// Raw reads are parsed into messages - use OnMessage() or OnMessages() instead
+    void OnRead(const uint8_t* Data, size_t Size) final;
+
+private:
+    std::vector<FrameView> m_Frames;    ///< Messages parsed from the current read
+};
+
+} // namespace DrowsyNetwork
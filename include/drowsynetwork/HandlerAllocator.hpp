@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Common.hpp"
+#include <cstddef>
+#include <new>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief Reusable storage for one outstanding async operation
+ *
+ * Every async operation needs a bit of memory for its state and completion
+ * handler. Normally asio gets that from the heap. A socket never has more
+ * than one read (or one write) in flight, so it can keep one small block
+ * per operation kind and reuse it for every operation instead.
+ *
+ * If the block is busy or too small the request falls back to the heap,
+ * so correctness never depends on the size guess.
+ */
+class HandlerMemory {
+public:
+    /// Bytes reserved per block - fits the library's read and write operations
+    static constexpr size_t Capacity = 1024;
+
+    HandlerMemory() noexcept : m_InUse(false) {}
+
+    HandlerMemory(const HandlerMemory&) = delete;
+    HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+    /**
+     * @brief Get memory for an operation
+     * @param Bytes Requested size
+     * @return The internal block if it's free and big enough, heap memory otherwise
+     */
+    void* Allocate(size_t Bytes) {
+        if (!m_InUse && Bytes <= Capacity) {
+            m_InUse = true;
+            return m_Storage;
+        }
+
+        return ::operator new(Bytes);
+    }
+
+    /**
+     * @brief Give memory back
+     * @param Pointer Memory returned by Allocate()
+     */
+    void Deallocate(void* Pointer) noexcept {
+        if (Pointer == m_Storage) {
+            m_InUse = false;
+        } else {
+            ::operator delete(Pointer);
+        }
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_Storage[Capacity]; ///< The reusable block
+    bool m_InUse;                                            ///< Block currently handed out
+};
+
+/**
+ * @brief Standard allocator adaptor over a HandlerMemory block
+ * @tparam T Allocated type (asio rebinds this to its operation types)
+ *
+ * Attach it to a handler with BindHandlerMemory() and asio will take the
+ * operation's memory from the block.
+ */
+template<typename T>
+class HandlerAllocator {
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& Memory) noexcept : m_Memory(&Memory) {}
+
+    template<typename U>
+    HandlerAllocator(const HandlerAllocator<U>& Other) noexcept : m_Memory(Other.m_Memory) {}
+
+    T* allocate(size_t Count) {
+        return static_cast<T*>(m_Memory->Allocate(sizeof(T) * Count));
+    }
+
+    void deallocate(T* Pointer, size_t) noexcept {
+        m_Memory->Deallocate(Pointer);
+    }
+
+    template<typename U>
+    bool operator==(const HandlerAllocator<U>& Other) const noexcept { return m_Memory == Other.m_Memory; }
+
+private:
+    template<typename> friend class HandlerAllocator;
+
+    HandlerMemory* m_Memory; ///< Block shared by all rebound copies
+};
+
+/**
+ * @brief Attach a HandlerMemory block to a completion handler
+ * @param Memory Block to allocate the operation from (must outlive the operation,
+ *               e.g. by letting the handler co-own it)
+ * @param Handler The completion handler
+ * @return Handler with an associated HandlerAllocator
+ *
+ * @code
+ * m_Socket->async_read_some(buffer, BindHandlerMemory(m_Operations->ReadMemory,
+ *     asio::bind_executor(m_Strand, [State = m_Operations](asio::error_code, size_t) { ... })));
+ * @endcode
+ */
+template<typename HandlerType>
+auto BindHandlerMemory(HandlerMemory& Memory, HandlerType&& Handler) {
+    return asio::bind_allocator(HandlerAllocator<void>(Memory), std::forward<HandlerType>(Handler));
+}
+
+/**
+ * @brief Attach asio's per-thread recycling allocator to a handler
+ * @param Handler The completion handler
+ * @return Handler with an associated recycling allocator
+ *
+ * For handlers that have no natural owner for a HandlerMemory block, like
+ * accepts or posts from other threads. Freed memory is cached per thread
+ * and reused by the next handler of similar size.
+ */
+template<typename HandlerType>
+auto BindRecyclingAllocator(HandlerType&& Handler) {
+    return asio::bind_allocator(asio::recycling_allocator<void>(), std::forward<HandlerType>(Handler));
+}
+
+} // namespace DrowsyNetwork
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <print>
+#include <atomic>
 
 /**
  * @file Logging.hpp
@@ -15,9 +16,91 @@
  * #define LOG_INFO(fmt, ...) spdlog::info(fmt, ##__VA_ARGS__)
  * #include <drowsynetwork/Logging.hpp>
  * @endcode
+ *
+ * Levels are filtered twice:
+ * - At compile time by DROWSY_LOG_LEVEL. Levels below it expand to nothing,
+ *   so their arguments are never evaluated.
+ * - At run time by DrowsyNetwork::SetLogLevel(). A compiled-in level that is
+ *   switched off costs one relaxed load and a well-predicted branch, again
+ *   without evaluating the arguments.
+ *
+ * So a release build with -DDROWSY_LOG_LEVEL=DROWSY_LOG_LEVEL_DEBUG and
+ * SetLogLevel(LogLevel::Info) carries debug logging that is free until
+ * someone turns it on.
  */
 
-// Default logging implementation using std::println
+/// Values for DROWSY_LOG_LEVEL
+#define DROWSY_LOG_LEVEL_DEBUG 0
+#define DROWSY_LOG_LEVEL_INFO 1
+#define DROWSY_LOG_LEVEL_WARN 2
+#define DROWSY_LOG_LEVEL_ERROR 3
+#define DROWSY_LOG_LEVEL_OFF 4
+
+#ifndef DROWSY_LOG_LEVEL
+// Debug logging is compiled out of release builds unless explicitly enabled
+#if defined(NDEBUG) && !defined(ENABLE_DEBUG_LOGGING)
+#define DROWSY_LOG_LEVEL DROWSY_LOG_LEVEL_INFO
+#else
+#define DROWSY_LOG_LEVEL DROWSY_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace DrowsyNetwork {
+
+/// Log severity, ordered from most to least verbose
+enum class LogLevel : int {
+    Debug = DROWSY_LOG_LEVEL_DEBUG,
+    Info = DROWSY_LOG_LEVEL_INFO,
+    Warn = DROWSY_LOG_LEVEL_WARN,
+    Error = DROWSY_LOG_LEVEL_ERROR,
+    Off = DROWSY_LOG_LEVEL_OFF
+};
+
+namespace Detail {
+    /// Runtime threshold, everything compiled in is enabled by default
+    inline std::atomic<LogLevel> g_LogLevel{LogLevel::Debug};
+}
+
+/**
+ * @brief Set the runtime log level
+ * @param Level Least severe level still written (LogLevel::Off silences everything)
+ *
+ * Levels removed by DROWSY_LOG_LEVEL stay off whatever this is set to.
+ */
+inline void SetLogLevel(LogLevel Level) {
+    Detail::g_LogLevel.store(Level, std::memory_order_relaxed);
+}
+
+/// Current runtime log level
+inline LogLevel GetLogLevel() {
+    return Detail::g_LogLevel.load(std::memory_order_relaxed);
+}
+
+/// Whether a message of this level would be written right now
+inline bool IsLogEnabled(LogLevel Level) {
+    return static_cast<int>(Level) >= static_cast<int>(GetLogLevel());
+}
+
+} // namespace DrowsyNetwork
+
+// Backend every default LOG_* macro writes through
+#ifdef DROWSYNETWORK_ASYNC_LOGGING
+// Built with ASYNC_LOGGING - formatted and written on a background thread so
+// logging never blocks an I/O thread
+#include "AsyncLogger.hpp"
+#define DROWSY_LOG_WRITE(fmt, ...) ::DrowsyNetwork::AsyncLogger::Log(fmt, ##__VA_ARGS__)
+#else
+#define DROWSY_LOG_WRITE(fmt, ...) std::println(fmt, ##__VA_ARGS__)
+#endif
+
+/// Write a message if its level is enabled at run time - the arguments are only evaluated then
+#define DROWSY_LOG_AT(Level, fmt, ...) \
+    do { \
+        if (::DrowsyNetwork::IsLogEnabled(::DrowsyNetwork::LogLevel::Level)) \
+            DROWSY_LOG_WRITE(fmt, ##__VA_ARGS__); \
+    } while (0)
+
+// Default logging implementation
 // Users can define their own LOG_* macros before including this header
 // to integrate with their preferred logging system
 
@@ -27,11 +110,16 @@
  * @param fmt Format string (printf-style)
  * @param ... Format arguments
  *
- * Debug logs are automatically disabled in release builds unless
- * ENABLE_DEBUG_LOGGING is defined. Use for verbose information that
- * helps during development but would clutter production logs.
+ * Debug logs are compiled out of release builds unless ENABLE_DEBUG_LOGGING
+ * is defined or DROWSY_LOG_LEVEL says otherwise. Use for verbose
+ * information that helps during development but would clutter production
+ * logs.
  */
-#define LOG_DEBUG(fmt, ...) std::println("[DEBUG] " fmt, ##__VA_ARGS__)
+#if DROWSY_LOG_LEVEL <= DROWSY_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) DROWSY_LOG_AT(Debug, "[DEBUG] " fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
 #endif
 
 #ifndef LOG_INFO
@@ -43,7 +131,11 @@
  * Use for normal operational messages like "Server started on port 8080"
  * or "Client connected". Should be meaningful but not overwhelming.
  */
-#define LOG_INFO(fmt, ...) std::println("[INFO] " fmt, ##__VA_ARGS__)
+#if DROWSY_LOG_LEVEL <= DROWSY_LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) DROWSY_LOG_AT(Info, "[INFO] " fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
 #endif
 
 #ifndef LOG_WARN
@@ -55,7 +147,11 @@
  * Use for situations that are unusual but not fatal, like connection
  * timeouts, retry attempts, or configuration fallbacks.
  */
-#define LOG_WARN(fmt, ...) std::println("[WARN] " fmt, ##__VA_ARGS__)
+#if DROWSY_LOG_LEVEL <= DROWSY_LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) DROWSY_LOG_AT(Warn, "[WARN] " fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) do {} while (0)
+#endif
 #endif
 
 #ifndef LOG_ERROR
@@ -67,14 +163,9 @@
  * Use for errors that prevent normal operation but don't crash the
  * application, like failed connections, invalid data, or resource exhaustion.
  */
-#define LOG_ERROR(fmt, ...) std::println("[ERROR] " fmt, ##__VA_ARGS__)
+#if DROWSY_LOG_LEVEL <= DROWSY_LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) DROWSY_LOG_AT(Error, "[ERROR] " fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
 #endif
-
-// Disable debug logging in release builds unless explicitly enabled
-#ifndef ENABLE_DEBUG_LOGGING
-#ifdef NDEBUG
-#undef LOG_DEBUG
-/// In release builds, debug logging becomes a no-op for performance
-#define LOG_DEBUG(fmt, ...) do {} while(0)
 #endif
-#endif
\ No newline at end of file
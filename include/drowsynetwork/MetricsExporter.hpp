@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Server.hpp"
+#include "ConnectionRegistry.hpp"
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief Serves the counters of other servers to Prometheus
+ *
+ * A small HTTP endpoint built on Server itself: GET /metrics answers with
+ * the Prometheus text exposition format for every server added with
+ * AddServer(). A scrape only reads the lock-free counters and histograms,
+ * so it never slows down the servers it reports on.
+ *
+ * Exported per server (label server="<name>"):
+ * - Accepts, accept errors by error code, opened/closed/open connections
+ * - Bytes, packets, reads and writes
+ * - Write queue depth (bytes and packets handed to Send() and not written)
+ * - The latency histograms of Server::GetLatency(), if SetLatencyTracking(true)
+ *
+ * @code
+ * DrowsyNetwork::MetricsExporter metrics(io);
+ * metrics.AddServer("game", gameServer);
+ * metrics.Bind("0.0.0.0", "9100");
+ * metrics.StartListening();
+ * @endcode
+ *
+ * Only enabled with the BUILD_METRICS_EXPORTER CMake option (on by default).
+ */
+class MetricsExporter : public Server {
+public:
+    /// Longest request (line plus headers) accepted before the connection is dropped
+    static constexpr size_t MaxRequestSize = 8 * 1024;
+
+    /**
+     * @brief Construct an exporter with nothing to export yet
+     * @param IOContext Context the HTTP connections run on
+     */
+    explicit MetricsExporter(Executor& IOContext);
+
+    /// Stops accepting before m_Connections goes away
+    ~MetricsExporter() override;
+
+    /**
+     * @brief Export a server's counters
+     * @param Name Value of the server label, should be unique
+     * @param Source Server to report on - its counters are shared, so it may die first
+     */
+    void AddServer(std::string Name, const Server& Source);
+
+    /**
+     * @brief Render all exported servers
+     * @return Prometheus text exposition format (version 0.0.4)
+     */
+    [[nodiscard]] std::string Render() const;
+
+protected:
+    void OnAccept(std::unique_ptr<TcpSocket>&& Socket) override;
+
+private:
+    /// One HTTP connection, defined in MetricsExporter.cpp
+    class Connection;
+
+    /// One exported server
+    struct Source {
+        std::string Name;                                ///< Server label
+        std::shared_ptr<const ServerCounters> Counters; ///< Shared with the server
+    };
+
+    /**
+     * @brief Everything a scrape reads
+     *
+     * Prometheus keeps its connections open between scrapes, and the
+     * registry doesn't close them when the exporter goes away. So every
+     * connection co-owns this instead of pointing back at the exporter.
+     */
+    struct SourceList {
+        mutable std::mutex Mutex;     ///< Guards Entries
+        std::vector<Source> Entries;  ///< Exported servers
+
+        /// See MetricsExporter::Render()
+        [[nodiscard]] std::string Render() const;
+    };
+
+    std::shared_ptr<SourceList> m_Sources; ///< Shared with every connection
+    ConnectionRegistry m_Connections;  ///< Keeps the HTTP connections alive
+};
+
+} // namespace DrowsyNetwork
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "PacketPool.hpp"
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
 namespace DrowsyNetwork {
 
 /**
@@ -8,12 +15,31 @@ namespace DrowsyNetwork {
  * This interface allows different packet types to be stored in the same
  * containers and queues. Every packet must be able to report its size
  * and provide access to its raw data.
+ *
+ * Packets carry their own reference count (see PacketRef) and are
+ * allocated from the PacketPool, so creating and releasing one doesn't
+ * hit the general purpose heap or a separate control block.
+ *
+ * The count is atomic, so one packet can be broadcast to sockets on
+ * different threads. Building with the SINGLE_THREADED_PACKETS CMake
+ * option (DROWSYNETWORK_SINGLE_THREADED_PACKETS) makes it a plain integer
+ * for applications where every packet is created, sent and released on
+ * one thread - a single io_context run by that same thread.
  */
 class IPacketBase {
 public:
     IPacketBase() = default;
     virtual ~IPacketBase() noexcept = default;
 
+    IPacketBase(const IPacketBase&) = delete;
+    IPacketBase& operator=(const IPacketBase&) = delete;
+
+    /// Packets live in the PacketPool
+    static void* operator new(size_t Size) { return PacketPool::Allocate(Size); }
+
+    /// Returns the packet's memory to the PacketPool
+    static void operator delete(void* Pointer, size_t Size) noexcept { PacketPool::Deallocate(Pointer, Size); }
+
     /**
      * @brief Get the total size of the packet in bytes
      * @return Size in bytes
@@ -31,6 +57,114 @@ public:
      * The data should be ready for network transmission.
      */
     [[nodiscard]] virtual const uint8_t* data() const noexcept = 0;
+
+#ifdef DROWSYNETWORK_SINGLE_THREADED_PACKETS
+    /// Add a reference (used by PacketRef)
+    void AddRef() const noexcept {
+        ++m_RefCount;
+    }
+
+    /// Drop a reference and destroy the packet with the last one (used by PacketRef)
+    void Release() const noexcept {
+        if (--m_RefCount == 0) {
+            delete this;
+        }
+    }
+
+    /// Current number of references
+    [[nodiscard]] uint32_t GetRefCount() const noexcept {
+        return m_RefCount;
+    }
+
+private:
+    /// Plain count - SINGLE_THREADED_PACKETS builds never share a packet between threads
+    mutable uint32_t m_RefCount = 0;
+#else
+    /// Add a reference (used by PacketRef)
+    void AddRef() const noexcept {
+        m_RefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Drop a reference and destroy the packet with the last one (used by PacketRef)
+    void Release() const noexcept {
+        if (m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    /// Current number of references
+    [[nodiscard]] uint32_t GetRefCount() const noexcept {
+        return m_RefCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// Atomic so one packet can be queued on sockets running on different threads
+    mutable std::atomic<uint32_t> m_RefCount{0};
+#endif
+};
+
+/**
+ * @brief Intrusive smart pointer for packets
+ * @tparam T IPacketBase or a type derived from it
+ *
+ * Works like std::shared_ptr, but the count lives inside the packet: no
+ * separate control block, no second pointer, and a copy is a single
+ * atomic increment. Converts implicitly from derived to base packets.
+ */
+template<typename T>
+class PacketRef {
+public:
+    using element_type = T;
+
+    PacketRef() noexcept = default;
+    PacketRef(std::nullptr_t) noexcept {}
+
+    /// Take a reference to a packet (the packet may already be referenced elsewhere)
+    explicit PacketRef(T* Packet) noexcept : m_Packet(Packet) {
+        if (m_Packet) m_Packet->AddRef();
+    }
+
+    PacketRef(const PacketRef& Other) noexcept : PacketRef(Other.m_Packet) {}
+
+    PacketRef(PacketRef&& Other) noexcept : m_Packet(std::exchange(Other.m_Packet, nullptr)) {}
+
+    template<typename U> requires std::convertible_to<U*, T*>
+    PacketRef(const PacketRef<U>& Other) noexcept : PacketRef(Other.get()) {}
+
+    template<typename U> requires std::convertible_to<U*, T*>
+    PacketRef(PacketRef<U>&& Other) noexcept : m_Packet(Other.Detach()) {}
+
+    ~PacketRef() { reset(); }
+
+    PacketRef& operator=(PacketRef Other) noexcept {
+        std::swap(m_Packet, Other.m_Packet);
+        return *this;
+    }
+
+    /// Drop the reference
+    void reset() noexcept {
+        if (auto Packet = std::exchange(m_Packet, nullptr)) {
+            Packet->Release();
+        }
+    }
+
+    [[nodiscard]] T* get() const noexcept { return m_Packet; }
+    T* operator->() const noexcept { return m_Packet; }
+    T& operator*() const noexcept { return *m_Packet; }
+    explicit operator bool() const noexcept { return m_Packet != nullptr; }
+
+    /// Number of references to the packet (0 if empty)
+    [[nodiscard]] long use_count() const noexcept { return m_Packet ? m_Packet->GetRefCount() : 0; }
+
+    /// Give up ownership without releasing (the caller now holds the reference)
+    [[nodiscard]] T* Detach() noexcept { return std::exchange(m_Packet, nullptr); }
+
+    template<typename U>
+    bool operator==(const PacketRef<U>& Other) const noexcept { return m_Packet == Other.get(); }
+    bool operator==(std::nullptr_t) const noexcept { return m_Packet == nullptr; }
+
+private:
+    T* m_Packet = nullptr; ///< Referenced packet
 };
 
 /**
@@ -158,10 +292,12 @@ public:
      * @brief Factory method for creating shared packet instances
      * @tparam Args Argument types for T's constructor
      * @param args Arguments to forward to T's constructor
-     * @return Shared pointer to the new packet
+     * @return Reference-counted pointer to the new packet
      *
      * This is the preferred way to create packets since the networking
      * system uses shared ownership for memory safety in async operations.
+     * The packet comes from the PacketPool and goes back to it when the
+     * last reference (usually the last socket that sent it) is dropped.
      *
      * @code
      * auto packet = PacketBase<std::string>::Create("Hello!");
@@ -169,19 +305,20 @@ public:
      * @endcode
      */
     template<typename... Args>
-    static std::shared_ptr<PacketBase<T>> Create(Args&&... args) {
-        return std::make_shared<PacketBase<T>>(std::forward<Args>(args)...);
+    static PacketRef<PacketBase<T>> Create(Args&&... args) {
+        static_assert(alignof(PacketBase<T>) <= alignof(std::max_align_t), "Over-aligned packet types are not supported by the PacketPool");
+        return PacketRef<PacketBase<T>>(new PacketBase<T>(std::forward<Args>(args)...));
     }
 
 private:
     T m_Data; ///< The actual packet data
 };
 
-/// Convenient alias for shared pointers to the base interface
-using IPacketBasePtr = std::shared_ptr<IPacketBase>;
+/// Convenient alias for references to the base interface
+using IPacketBasePtr = PacketRef<IPacketBase>;
 
-/// Convenient alias for shared pointers to typed packets
+/// Convenient alias for references to typed packets
 template<PacketConcept T>
-using PacketPtr = std::shared_ptr<PacketBase<T>>;
+using PacketPtr = PacketRef<PacketBase<T>>;
 
 } // namespace DrowsyNetwork
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief Size-classed memory pool for packet objects
+ *
+ * Packets are small, short-lived and created at very high rates, which
+ * makes them a poor fit for the general purpose heap. The pool rounds every
+ * request up to a size class and keeps freed blocks in per-thread free
+ * lists, so the common create/send/release cycle never takes a lock.
+ *
+ * Every block remembers the thread that allocated it. A block freed on
+ * another thread - typically a broadcast packet created on a game thread
+ * and released by the I/O thread that wrote it last - is pushed onto a
+ * lock-free return list of its owner, which picks the whole list up the
+ * next time its own free list runs dry. Producers therefore keep reusing
+ * their blocks instead of draining into the I/O threads' caches.
+ * Requests above the largest class go straight to the heap.
+ *
+ * You normally don't use this directly - every IPacketBase is allocated
+ * from it automatically.
+ */
+class PacketPool {
+public:
+    /// Largest object size served from the size classes
+    static constexpr size_t MaxPooledSize = 512;
+
+    /// Maximum free blocks cached per size class and thread (and waiting on its return list)
+    static constexpr size_t MaxCachedPerClass = 256;
+
+    /**
+     * @brief Get memory for an object
+     * @param Size Object size in bytes
+     * @return Memory suitably aligned for any packet type
+     */
+    static void* Allocate(size_t Size);
+
+    /**
+     * @brief Give memory back to the pool
+     * @param Pointer Memory returned by Allocate()
+     * @param Size The same size that was passed to Allocate()
+     */
+    static void Deallocate(void* Pointer, size_t Size) noexcept;
+};
+
+} // namespace DrowsyNetwork
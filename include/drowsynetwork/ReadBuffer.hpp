@@ -0,0 +1,231 @@
+#pragma once
+
+#include "Common.hpp"
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief Shared pool of equally sized receive blocks
+ *
+ * Lets many sockets share a small set of read buffers instead of each one
+ * holding its own. A pooled ReadBuffer only borrows a block while it
+ * actually has data to process, so idle connections cost no buffer memory
+ * at all. Released blocks are cached for reuse up to a limit.
+ *
+ * Thread-safe - one pool can serve sockets running on any thread. Every
+ * thread keeps up to MaxCachedPerThread released blocks to itself, so
+ * borrowing and returning a block takes no lock. Only when a thread's list
+ * runs dry or overflows does it trade half a list with the shared overflow
+ * (at most MaxCached blocks) under a mutex.
+ *
+ * @code
+ * auto pool = std::make_shared<DrowsyNetwork::ReadBufferPool>(16 * 1024);
+ * auto client = std::make_shared<MySocket>(m_IoContext, std::move(socket), pool);
+ * @endcode
+ */
+class ReadBufferPool {
+public:
+    /// Default number of released blocks kept in the shared overflow
+    static constexpr size_t DefaultMaxCached = 1024;
+
+    /// Released blocks one thread keeps to itself
+    static constexpr size_t MaxCachedPerThread = 32;
+
+    ReadBufferPool() = delete;
+
+    /**
+     * @brief Construct a pool
+     * @param BlockSize Size of every block (the capacity of pooled buffers)
+     * @param MaxCached Maximum number of free blocks kept in the shared
+     *        overflow, on top of up to MaxCachedPerThread per thread
+     */
+    explicit ReadBufferPool(size_t BlockSize, size_t MaxCached = DefaultMaxCached);
+
+    ReadBufferPool(const ReadBufferPool&) = delete;
+    ReadBufferPool& operator=(const ReadBufferPool&) = delete;
+
+    /**
+     * @brief Take a block from the pool (allocates if none is cached)
+     * @return Block of GetBlockSize() bytes
+     */
+    [[nodiscard]] std::unique_ptr<uint8_t[]> Acquire();
+
+    /**
+     * @brief Give a block back to the pool
+     * @param Block Block previously returned by Acquire()
+     */
+    void Release(std::unique_ptr<uint8_t[]>&& Block);
+
+    /// Size of every block in bytes
+    [[nodiscard]] size_t GetBlockSize() const noexcept { return m_BlockSize; }
+
+private:
+    using Block = std::unique_ptr<uint8_t[]>;
+
+    struct Overflow;
+    struct ThreadCache;
+
+    /// Calling thread's free list for this pool, nullptr once the thread's cache is gone
+    std::vector<Block>* GetThreadFree();
+
+    size_t m_BlockSize;                   ///< Size of every block
+    uint64_t m_Id;                        ///< Identifies the pool in thread caches, never reused
+    std::shared_ptr<Overflow> m_Overflow; ///< Shared free blocks, outlives the pool in thread caches
+};
+
+/**
+ * @brief Fixed-capacity receive buffer with in-place compaction
+ *
+ * The storage is allocated once when the buffer is created and never grows,
+ * so the steady-state read path doesn't touch the allocator at all. Data is
+ * appended at the tail and consumed from the head. When everything has been
+ * consumed both ends simply jump back to the start; unread bytes are only
+ * moved to the front when the free tail becomes too short to be useful.
+ *
+ * A buffer can also borrow its storage from a ReadBufferPool. It then only
+ * holds a block while there is unread data and hands it back on Release().
+ *
+ * Typical read cycle:
+ * @code
+ * socket.async_read_some(buffer.Prepare(), [&](auto ErrorCode, size_t Bytes) {
+ *     buffer.Commit(Bytes);
+ *     auto Used = Parse(buffer.Data(), buffer.Size());
+ *     buffer.Consume(Used);
+ * });
+ * @endcode
+ */
+class ReadBuffer {
+public:
+    /// Default capacity - big enough for a few typical messages per read
+    static constexpr size_t DefaultCapacity = 16 * 1024;
+
+    ReadBuffer() = delete;
+
+    /**
+     * @brief Construct a buffer with a fixed capacity
+     * @param Capacity Total number of bytes the buffer can hold
+     */
+    explicit ReadBuffer(size_t Capacity) :
+        m_Storage(std::make_unique_for_overwrite<uint8_t[]>(Capacity)),
+        m_Capacity(Capacity),
+        m_ReadPos(0),
+        m_WritePos(0)
+    {
+    }
+
+    /**
+     * @brief Construct a buffer that borrows its storage from a pool
+     * @param Pool Pool to borrow blocks from (capacity is the block size)
+     *
+     * No block is taken until the first Prepare().
+     */
+    explicit ReadBuffer(std::shared_ptr<ReadBufferPool> Pool) :
+        m_Pool(std::move(Pool)),
+        m_Capacity(m_Pool->GetBlockSize()),
+        m_ReadPos(0),
+        m_WritePos(0)
+    {
+    }
+
+    ~ReadBuffer() {
+        if (m_Pool && m_Storage) {
+            m_Pool->Release(std::move(m_Storage));
+        }
+    }
+
+    ReadBuffer(const ReadBuffer&) = delete;
+    ReadBuffer& operator=(const ReadBuffer&) = delete;
+
+    /**
+     * @brief Get the writable tail of the buffer
+     * @return Buffer covering all free space after the unread data
+     *
+     * Compacts the unread data to the front first if the tail has become
+     * short (less than a quarter of the capacity). The returned buffer is
+     * empty only if the unread data fills the whole capacity. A pooled
+     * buffer without storage borrows a block first.
+     */
+    [[nodiscard]] Buffer Prepare() {
+        if (!m_Storage) {
+            m_Storage = m_Pool->Acquire();
+        }
+
+        if (m_ReadPos == m_WritePos) {
+            m_ReadPos = m_WritePos = 0;
+        } else if (m_ReadPos > 0 && m_Capacity - m_WritePos < m_Capacity / 4) {
+            std::memmove(m_Storage.get(), m_Storage.get() + m_ReadPos, Size());
+            m_WritePos -= m_ReadPos;
+            m_ReadPos = 0;
+        }
+
+        return Buffer(m_Storage.get() + m_WritePos, m_Capacity - m_WritePos);
+    }
+
+    /**
+     * @brief Mark bytes written into the prepared tail as readable
+     * @param Bytes Number of bytes that were written
+     */
+    void Commit(size_t Bytes) noexcept {
+        m_WritePos += std::min(Bytes, m_Capacity - m_WritePos);
+    }
+
+    /**
+     * @brief Drop bytes from the front of the readable data
+     * @param Bytes Number of bytes to drop
+     */
+    void Consume(size_t Bytes) noexcept {
+        m_ReadPos += std::min(Bytes, Size());
+        if (m_ReadPos == m_WritePos) {
+            m_ReadPos = m_WritePos = 0;
+        }
+    }
+
+    /// Drop all readable data
+    void Clear() noexcept { m_ReadPos = m_WritePos = 0; }
+
+    /**
+     * @brief Hand the storage back to the pool if nothing is left to read
+     * @return true if the buffer no longer holds a block
+     *
+     * Does nothing for buffers that own their storage.
+     */
+    bool Release() {
+        if (!m_Pool || !Empty())
+            return false;
+
+        if (m_Storage) {
+            m_Pool->Release(std::move(m_Storage));
+        }
+
+        return true;
+    }
+
+    /// True if the storage is borrowed from a ReadBufferPool
+    [[nodiscard]] bool IsPooled() const noexcept { return m_Pool != nullptr; }
+
+    /// Pointer to the first readable byte
+    [[nodiscard]] const uint8_t* Data() const noexcept { return m_Storage.get() + m_ReadPos; }
+
+    /// Number of readable bytes
+    [[nodiscard]] size_t Size() const noexcept { return m_WritePos - m_ReadPos; }
+
+    /// True if there is nothing to read
+    [[nodiscard]] bool Empty() const noexcept { return m_ReadPos == m_WritePos; }
+
+    /// Total number of bytes the buffer can hold
+    [[nodiscard]] size_t Capacity() const noexcept { return m_Capacity; }
+
+private:
+    std::shared_ptr<ReadBufferPool> m_Pool; ///< Pool the storage is borrowed from, if any
+    std::unique_ptr<uint8_t[]> m_Storage; ///< Fixed storage, allocated once
+    size_t m_Capacity;                    ///< Size of m_Storage in bytes
+    size_t m_ReadPos;                     ///< Offset of the first unread byte
+    size_t m_WritePos;                    ///< Offset one past the last unread byte
+};
+
+} // namespace DrowsyNetwork
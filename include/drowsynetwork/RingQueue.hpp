@@ -0,0 +1,116 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace DrowsyNetwork {
+
+/**
+ * @brief FIFO queue over a growable ring of slots
+ *
+ * std::deque allocates and frees a node every few dozen elements as items
+ * flow through it, even when the queue never holds more than a handful.
+ * This queue keeps one power-of-two array instead and only allocates when
+ * it has to grow, so once it has seen its peak depth, pushing and popping
+ * never touch the heap again. Capacity is never given back.
+ *
+ * @code
+ * RingQueue<int> Queue;
+ * Queue.Reserve(64);
+ * Queue.PushBack(1);
+ * auto Value = std::move(Queue.Front());
+ * Queue.PopFront();
+ * @endcode
+ */
+template<typename T>
+class RingQueue {
+public:
+    RingQueue() = default;
+
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    ~RingQueue() { Clear(); }
+
+    /**
+     * @brief Append an element at the back
+     * @param Value Element to append
+     *
+     * Grows (doubling) if the ring is full.
+     */
+    void PushBack(T&& Value) {
+        if (m_Size == m_Capacity)
+            Grow(m_Capacity ? m_Capacity * 2 : MinCapacity);
+
+        std::construct_at(Slot(m_Size), std::move(Value));
+        ++m_Size;
+    }
+
+    /// Oldest element (queue must not be empty)
+    [[nodiscard]] T& Front() noexcept { return *Slot(0); }
+    [[nodiscard]] const T& Front() const noexcept { return *Slot(0); }
+
+    /// Remove the oldest element (queue must not be empty)
+    void PopFront() noexcept {
+        std::destroy_at(Slot(0));
+        m_Head = (m_Head + 1) & (m_Capacity - 1);
+        --m_Size;
+    }
+
+    /// Remove every element, keeping the capacity
+    void Clear() noexcept {
+        while (m_Size) {
+            PopFront();
+        }
+        m_Head = 0;
+    }
+
+    /**
+     * @brief Make room for at least Count elements up front
+     * @param Count Number of elements the queue should hold without growing
+     */
+    void Reserve(size_t Count) {
+        if (Count > m_Capacity)
+            Grow(std::bit_ceil(Count));
+    }
+
+    [[nodiscard]] size_t Size() const noexcept { return m_Size; }
+    [[nodiscard]] bool Empty() const noexcept { return m_Size == 0; }
+    [[nodiscard]] size_t Capacity() const noexcept { return m_Capacity; }
+
+private:
+    /// Capacity of the first allocation
+    static constexpr size_t MinCapacity = 16;
+
+    /// Raw storage of one element
+    struct alignas(T) Storage {
+        std::byte Bytes[sizeof(T)];
+    };
+
+    [[nodiscard]] T* Slot(size_t Index) const noexcept {
+        return reinterpret_cast<T*>(&m_Slots[(m_Head + Index) & (m_Capacity - 1)]);
+    }
+
+    /// Move every element into a new ring of NewCapacity (a power of two) slots
+    void Grow(size_t NewCapacity) {
+        auto NewSlots = std::make_unique_for_overwrite<Storage[]>(NewCapacity);
+        for (size_t Index = 0; Index < m_Size; ++Index) {
+            auto* Element = Slot(Index);
+            std::construct_at(reinterpret_cast<T*>(&NewSlots[Index]), std::move(*Element));
+            std::destroy_at(Element);
+        }
+
+        m_Slots = std::move(NewSlots);
+        m_Capacity = NewCapacity;
+        m_Head = 0;
+    }
+
+    std::unique_ptr<Storage[]> m_Slots; ///< Ring of m_Capacity slots
+    size_t m_Capacity = 0;              ///< Slot count, zero or a power of two
+    size_t m_Head = 0;                  ///< Slot of the oldest element
+    size_t m_Size = 0;                  ///< Elements in the ring
+};
+
+} // namespace DrowsyNetwork
@@ -1,9 +1,55 @@
 #pragma once
 
 #include "Common.hpp"
+#include "ExecutorPool.hpp"
+#include "Stats.hpp"
+#include <chrono>
+#include <memory>
+#include <condition_variable>
+#include <mutex>
 
 namespace DrowsyNetwork {
 
+/**
+ * @brief Listen socket settings for Server::Bind()
+ *
+ * The defaults match a plain Bind(). Options the platform doesn't support
+ * are skipped with a warning; TCP_DEFER_ACCEPT and SO_INCOMING_CPU are
+ * Linux only.
+ *
+ * @code
+ * DrowsyNetwork::AcceptorOptions options;
+ * options.DeferAccept = std::chrono::seconds(5); // no Socket until the client sends something
+ * options.FastOpenQueueLength = 256;             // data in the SYN saves a round trip
+ * options.Backlog = 4096;
+ * server.Bind("0.0.0.0", "8080", options);
+ * @endcode
+ */
+struct AcceptorOptions {
+    /// SO_REUSEPORT - several acceptors (one per thread) share the port, the kernel balances between them
+    bool ReusePort = false;
+
+    /// listen() backlog, capped by the kernel (net.core.somaxconn on Linux)
+    int Backlog = asio::socket_base::max_listen_connections;
+
+    /**
+     * TCP_DEFER_ACCEPT - only report a connection once its first data
+     * arrived, or this much time passed. Connections that never send
+     * anything then cost neither a Socket nor a read. Zero turns it off.
+     */
+    std::chrono::seconds DeferAccept{0};
+
+    /// TCP_FASTOPEN - how many Fast Open requests may wait for accept() (0 = off)
+    int FastOpenQueueLength = 0;
+
+    /**
+     * SO_INCOMING_CPU - with ReusePort, steer connections arriving on this
+     * CPU to this acceptor. Pair it with ExecutorPool::Run(true), which
+     * pins context N to CPU N. Negative leaves it unset.
+     */
+    int IncomingCpu = -1;
+};
+
 /**
  * @brief Base class for TCP servers
  *
@@ -20,10 +66,12 @@ namespace DrowsyNetwork {
  * public:
  *     MyServer(asio::io_context& io) : Server(io) {}
  *
+ *     ~MyServer() override { Stop(); } // before m_clients goes away
+ *
  * protected:
  *     void OnAccept(std::unique_ptr<TcpSocket>&& socket) override {
  *         auto client = std::make_shared<MySocket>(m_IoContext, std::move(socket));
- *         client->Setup();
+ *         client->Setup(m_Counters);
  *         m_clients.push_back(client);
  *     }
  * };
@@ -43,17 +91,35 @@ public:
     explicit Server(Executor& IOContext);
 
     /**
-     * @brief Virtual destructor - properly closes all acceptors
+     * @brief Virtual destructor - calls Stop() and closes all acceptors
      *
-     * Automatically closes any open acceptors and cleans up resources.
-     * It's safe to destroy the server even if it's currently listening.
+     * By the time this runs, the members of a derived class are already
+     * destroyed, while an accept completing on another thread may still be
+     * calling OnAccept(). A derived class whose OnAccept() uses its own
+     * members must call Stop() first thing in its own destructor (or its
+     * owner must, before destroying it).
      */
     virtual ~Server();
 
+    /**
+     * @brief Stop accepting for good
+     *
+     * Waits for accept and retry completions that are running right now to
+     * return, makes the ones still queued do nothing, cancels the retry
+     * timers and closes every acceptor. After it returns OnAccept() is
+     * never called again. Calling it more than once is fine.
+     *
+     * OnAccept() must not stop or destroy its own server, nor wait for
+     * anything that does - Stop() would wait for that very OnAccept() to
+     * return.
+     */
+    void Stop();
+
     /**
      * @brief Bind to a host and port combination
      * @param Host Hostname or IP address (e.g., "localhost", "0.0.0.0", "::1")
      * @param Port Port number or service name (e.g., "8080", "http")
+     * @param Options Listen socket settings for every resolved address
      * @return true if bound to at least one address, false if all failed
      *
      * This method resolves the hostname and attempts to bind to all resulting
@@ -65,11 +131,12 @@ public:
      * - Bind("::", "8080") - Listen on all IPv6 interfaces
      * - Bind("localhost", "8080") - Listen on loopback only
      */
-    bool Bind(std::string_view Host, std::string_view Port);
+    bool Bind(std::string_view Host, std::string_view Port, const AcceptorOptions& Options = {});
 
     /**
      * @brief Bind to a specific endpoint
      * @param Endpoint Pre-constructed TCP endpoint
+     * @param Options Listen socket settings
      * @return true if successfully bound, false otherwise
      *
      * Use this when you need precise control over the binding address,
@@ -80,7 +147,7 @@ public:
      * server.Bind(ep);
      * @endcode
      */
-    bool Bind(const TcpEndpoint& Endpoint);
+    bool Bind(const TcpEndpoint& Endpoint, const AcceptorOptions& Options = {});
 
     /**
      * @brief Start listening for connections on all bound addresses
@@ -103,17 +170,187 @@ public:
      */
     [[nodiscard]] TcpAcceptor* GetAcceptor(size_t Index);
 
+    /**
+     * @brief Set how many connections one accept wakeup may take
+     * @param BatchSize Maximum connections per wakeup, 0 to drain until the backlog is empty
+     *
+     * After each completed accept the server keeps taking connections that
+     * are already waiting in the listen backlog with non-blocking accepts,
+     * until the backlog is empty or BatchSize connections were taken. One
+     * wakeup can therefore serve a whole burst of connections.
+     */
+    void SetAcceptBatchSize(size_t BatchSize);
+
+    /**
+     * @brief Set how many accepts each acceptor keeps pending
+     * @param Count Outstanding async accepts per acceptor (at least 1)
+     *
+     * With a single pending accept, every connection of a burst waits for
+     * the previous completion to run and re-arm. With several, one
+     * readiness wakeup completes several accepts at once, and on a
+     * multi-threaded m_IoContext the completions run in parallel.
+     *
+     * Takes effect on the next StartListening(). With more than one pending
+     * accept and m_IoContext run by several threads, OnAccept() may be
+     * called concurrently, so it has to be thread-safe.
+     */
+    void SetConcurrentAccepts(size_t Count);
+
+    /**
+     * @brief Limit how fast connections are accepted
+     * @param ConnectionsPerSecond Sustained accept rate, 0 for no limit
+     * @param Burst Connections that may be accepted back to back after a quiet spell (0 = one second's worth)
+     *
+     * A token bucket: every accept takes a token and tokens come back at
+     * ConnectionsPerSecond. Without a token the server doesn't arm its next
+     * accept, so a connection flood piles up in the kernel's listen backlog
+     * (and overflows there) instead of costing a Socket per connection.
+     */
+    void SetAcceptRateLimit(double ConnectionsPerSecond, size_t Burst = 0);
+
+    /**
+     * @brief Cap the number of open connections
+     * @param MaxConnections Connections that may be open at once, 0 for no cap
+     *
+     * At the cap the server stops accepting - rather than accepting and
+     * closing - and checks again every AcceptRetryInterval. Connections
+     * arriving meanwhile wait in the listen backlog.
+     *
+     * A connection counts from the moment it is passed to OnAccept() until
+     * the socket made from it disconnects, so that socket has to be set up
+     * with Setup(m_Counters). A connection OnAccept() doesn't take (leaves
+     * the pointer alone) is released right away.
+     */
+    void SetMaxConnections(size_t MaxConnections);
+
+    /**
+     * @brief Whether any acceptor is held back right now
+     * @return true while the rate limit, the connection cap or a descriptor shortage keeps accepts from being armed
+     */
+    [[nodiscard]] bool IsAcceptPaused() const;
+
+    /**
+     * @brief Enable SO_REUSEPORT on acceptors created by later Bind() calls
+     * @param ReusePort true to let several acceptors share the same port
+     *
+     * With SO_REUSEPORT, one server per ExecutorPool context can bind the
+     * same address and the kernel spreads incoming connections between
+     * them. Ignored (with a warning) on platforms without SO_REUSEPORT.
+     * Same as AcceptorOptions::ReusePort on every Bind().
+     */
+    void SetReusePort(bool ReusePort);
+
+    /**
+     * @brief Hand accepted connections out to the contexts of a pool
+     * @param Pool Pool to spread connections over, nullptr to keep them on m_IoContext
+     *
+     * Every accepted socket is created on the pool's next context in
+     * round-robin order. Create your Socket on that same context, see
+     * GetSocketExecutor(). The pool must outlive the server.
+     */
+    void SetExecutorPool(ExecutorPool* Pool);
+
+    /**
+     * @brief Get the context an accepted socket belongs to
+     * @param Socket Socket passed to OnAccept()
+     * @return The context the socket's I/O runs on
+     *
+     * Use this in OnAccept() when the server hands connections to an
+     * ExecutorPool, so the Socket and its strand live on the same thread
+     * as the connection:
+     * @code
+     * void OnAccept(std::unique_ptr<TcpSocket>&& socket) override {
+     *     auto& context = GetSocketExecutor(*socket);
+     *     auto client = std::make_shared<MySocket>(context, std::move(socket));
+     *     client->Setup(m_Counters);
+     * }
+     * @endcode
+     */
+    [[nodiscard]] static Executor& GetSocketExecutor(TcpSocket& Socket);
+
+    /**
+     * @brief Get a snapshot of the server's counters
+     * @return Accepts plus traffic summed over all sockets set up with m_Counters
+     *
+     * Cheap enough to call every second from a monitoring thread. Take two
+     * snapshots and divide by the time between them for rates.
+     */
+    [[nodiscard]] ServerStats GetStats() const;
+
+    /**
+     * @brief Get the live counters behind GetStats() and GetLatency()
+     * @return The counters, which stay valid even after the server is gone
+     */
+    [[nodiscard]] std::shared_ptr<const ServerCounters> GetCounters() const { return m_Counters; }
+
+    /**
+     * @brief Get a latency histogram of the sockets set up with m_Counters
+     * @param Metric Which part of a packet's or read's life to look at
+     * @return Snapshot to query percentiles from (empty unless SetLatencyTracking(true))
+     *
+     * Comparing the send metrics tells where tail latency comes from:
+     * SendDispatch is strand contention (only Send() calls from off the
+     * strand are sampled), SendQueue minus SendDispatch is waiting behind
+     * other packets, SendToWire minus SendQueue is the write itself (slow
+     * peer or full socket buffer). ReadHandler is time spent in your
+     * OnRead().
+     *
+     * @code
+     * auto wire = server.GetLatency(DrowsyNetwork::LatencyMetric::SendToWire);
+     * LOG_INFO("send p50 {}ns p99 {}ns max {}ns", wire.GetPercentileNs(50), wire.GetPercentileNs(99), wire.MaxNs);
+     * @endcode
+     */
+    [[nodiscard]] HistogramSnapshot GetLatency(LatencyMetric Metric) const;
+
+    /**
+     * @brief Turn latency tracking on or off (off by default)
+     * @param Enabled Whether sockets accepted from now on timestamp their packets and reads
+     *
+     * Tracking costs two clock reads per packet and one per read, so
+     * GetLatency() stays empty until you opt in. Sockets that already exist
+     * keep their setting - enable it before StartListening().
+     */
+    void SetLatencyTracking(bool Enabled);
+
+    /// Default maximum connections taken per accept wakeup
+    static constexpr size_t DefaultAcceptBatchSize = 64;
+
+    /// Default outstanding async accepts per acceptor
+    static constexpr size_t DefaultConcurrentAccepts = 1;
+
+    /// How often an acceptor paused at the connection cap checks again
+    static constexpr std::chrono::milliseconds AcceptRetryInterval{10};
+
+    /// First pause after running out of descriptors, doubled on every further shortage
+    static constexpr std::chrono::milliseconds MinAcceptBackoff{10};
+
+    /// Longest pause after running out of descriptors
+    static constexpr std::chrono::milliseconds MaxAcceptBackoff{1000};
+
 protected:
     /**
      * @brief Create a new acceptor for the given protocol
      * @param Protocol TCP protocol (IPv4 or IPv6)
+     * @param Options Listen socket settings, the backlog is kept for StartListening()
      * @return Pointer to the new acceptor, or nullptr if creation failed
      *
      * This method creates and configures a new acceptor with sensible defaults:
      * - Reuse address option enabled
+     * - Reuse port option enabled if requested with SetReusePort() or Options
      * - IPv6-only flag set for IPv6 acceptors
+     * - Whatever else Options asks for
+     */
+    [[nodiscard]] TcpAcceptor* CreateAcceptor(const asio::ip::tcp& Protocol, const AcceptorOptions& Options = {});
+
+    /**
+     * @brief Apply the platform specific parts of AcceptorOptions
+     * @param Acceptor Open, not yet listening acceptor
+     * @param Options Settings to apply
+     *
+     * Failures are logged and otherwise ignored - the acceptor works
+     * without them, just less efficiently.
      */
-    [[nodiscard]] TcpAcceptor* CreateAcceptor(const asio::ip::tcp& Protocol);
+    static void ApplyAcceptorOptions(TcpAcceptor& Acceptor, const AcceptorOptions& Options);
 
     /**
      * @brief Start async accept operation for a specific acceptor
@@ -136,6 +373,76 @@ protected:
      */
     void Accept(size_t Index, std::unique_ptr<TcpSocket>&& Socket, asio::error_code ErrorCode);
 
+    /**
+     * @brief Count a connection and pass it to OnAccept()
+     * @param Socket The new client socket
+     *
+     * The connection counts against SetMaxConnections() until its socket
+     * disconnects, or right away again if OnAccept() doesn't take it.
+     */
+    void HandOff(std::unique_ptr<TcpSocket>&& Socket);
+
+    /**
+     * @brief Take connections already waiting in the listen backlog
+     * @param Index Acceptor index to drain
+     *
+     * Called after every successful accept. Uses non-blocking accepts and
+     * stops on would_block, on an error, or when the batch size is reached.
+     */
+    void DrainBacklog(size_t Index);
+
+    /**
+     * @brief Take one connection from the listen backlog without blocking
+     * @param Acceptor Non-blocking acceptor to take it from
+     * @param Socket Unopened socket receiving the connection
+     * @param ErrorCode Set to would_block once the backlog is empty
+     *
+     * On Linux this is a single accept4() that creates the descriptor
+     * non-blocking and close-on-exec, and skips connections that were
+     * reset while still queued.
+     */
+    static void AcceptQueued(TcpAcceptor& Acceptor, TcpSocket& Socket, asio::error_code& ErrorCode);
+
+    /**
+     * @brief Reserve one accept if admission control lets it through
+     * @param Index Acceptor that wants to accept
+     * @param PauseIfDenied Pause the acceptor when denied, it then resumes by itself
+     * @return true if the accept may go ahead - call ReleaseAccept() once it's done
+     *
+     * Checks the descriptor back-off, the connection cap (counting accepts
+     * in flight) and the accept rate limit, in that order.
+     */
+    bool ReserveAccept(size_t Index, bool PauseIfDenied);
+
+    /**
+     * @brief Finish an accept reserved with ReserveAccept()
+     * @param Accepted Whether it produced a connection (otherwise its token is given back)
+     */
+    void ReleaseAccept(bool Accepted);
+
+    /**
+     * @brief Re-arm the accepts an acceptor paused on
+     * @param Index Acceptor to resume
+     */
+    void ResumeAccepting(size_t Index);
+
+    /**
+     * @brief React to running out of descriptors or kernel memory
+     * @param Index Acceptor whose accept failed
+     *
+     * Frees the reserve descriptor to take one waiting connection and
+     * close it right away - the peer gets an answer instead of hanging,
+     * and the listen socket stops reporting the same connection - then
+     * backs accepting off for a while instead of spinning on the error.
+     */
+    void HandleResourceExhaustion(size_t Index);
+
+    /**
+     * @brief Pick the context for the next accepted socket
+     * @return The pool's next context, or m_IoContext without a pool
+     */
+    Executor& NextSocketExecutor();
+
     /**
      * @brief Safely close an acceptor
      * @param Acceptor Reference to the acceptor to close
@@ -156,7 +463,7 @@ protected:
      * @code
      * void OnAccept(std::unique_ptr<TcpSocket>&& socket) override {
      *     auto client = std::make_shared<MySocket>(m_IoContext, std::move(socket));
-     *     client->Setup();  // Important! This starts the read loop
+     *     client->Setup(m_Counters);  // Important! This starts the read loop
      * }
      * @endcode
      */
@@ -166,6 +473,75 @@ protected:
     Executor& m_IoContext;           ///< Reference to the I/O context
     std::vector<TcpAcceptor> m_Acceptors; ///< All bound acceptors
     TcpResolver m_Resolver;          ///< For hostname resolution
+    size_t m_AcceptBatchSize;        ///< Maximum connections per accept wakeup (0 = until the backlog is empty)
+    size_t m_ConcurrentAccepts;      ///< Outstanding async accepts per acceptor
+    bool m_ReusePort;                ///< Set SO_REUSEPORT on new acceptors
+    ExecutorPool* m_ExecutorPool;    ///< Contexts accepted sockets are spread over
+    std::shared_ptr<ServerCounters> m_Counters; ///< Shared with the sockets, which may outlive the server
+
+private:
+    /// Settings and admission state of one acceptor, guarded by m_AdmissionMutex
+    struct AcceptLoop {
+        AcceptLoop(Executor& Context, int Backlog) : RetryTimer(Context), Backlog(Backlog) {}
+
+        asio::steady_timer RetryTimer; ///< Resumes paused accepts
+        size_t PausedAccepts = 0;      ///< Accepts not armed while paused
+        bool IsRetryPending = false;   ///< RetryTimer is running
+        bool IsPaused = false;         ///< Denied since the last armed accept
+        int Backlog;                   ///< listen() backlog from AcceptorOptions
+    };
+
+    mutable std::mutex m_AdmissionMutex; ///< Guards everything below
+    std::vector<std::unique_ptr<AcceptLoop>> m_AcceptLoops; ///< Same index as m_Acceptors
+    size_t m_MaxConnections;         ///< Open connection cap (0 = none)
+    size_t m_ReservedAccepts;        ///< Accepts admitted but not finished yet
+    double m_AcceptRate;             ///< Tokens per second (0 = no rate limit)
+    double m_AcceptBurst;            ///< Bucket size
+    double m_AcceptTokens;           ///< Tokens left
+    StatsClock::time_point m_AcceptTokensUpdated; ///< Last refill of m_AcceptTokens
+    StatsClock::duration m_AcceptBackoff; ///< Current descriptor back-off (0 = none)
+    StatsClock::time_point m_AcceptBackoffUntil; ///< No accepts before this
+    int m_ReserveDescriptor;         ///< Spare descriptor freed to shed a connection (-1 if none)
+
+    /**
+     * @brief Tells completions whether the server still accepts
+     *
+     * Accept and retry timer completions capture `this`, and Stop() can't
+     * take back a completion that is already queued. Every such handler
+     * co-owns this and registers in Running before touching the server
+     * (no lock is held while it runs). Stop() clears IsAlive and waits for
+     * Running to drop to zero - so a handler either finishes before the
+     * server stops or sees that it's gone.
+     */
+    struct Lifetime {
+        std::mutex Mutex;                 ///< Guards IsAlive and Running
+        std::condition_variable Finished; ///< Signalled when Running drops to zero
+        size_t Running = 0;               ///< Completions inside the server right now
+        bool IsAlive = true;              ///< Cleared by Stop()
+
+        /// Register a completion, false once the server stopped
+        bool Enter();
+
+        /// Unregister a completion registered with Enter()
+        void Leave();
+    };
+
+    /// Run a completion unless the server stopped
+    template<typename FunctionType>
+    static void RunIfAlive(Lifetime& State, FunctionType&& Function) {
+        if (!State.Enter())
+            return;
+
+        // Leave even if OnAccept() throws, or Stop() would wait forever
+        struct Leaving {
+            Lifetime& State;
+            ~Leaving() { State.Leave(); }
+        } Guard{ State };
+
+        Function();
+    }
+
+    std::shared_ptr<Lifetime> m_Lifetime; ///< Co-owned by every accept and retry completion
 };
 
 } // namespace DrowsyNetwork
\ No newline at end of file
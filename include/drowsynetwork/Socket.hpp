@@ -2,13 +2,50 @@
 
 #include "Common.hpp"
 #include "PacketBase.hpp"
+#include "ReadBuffer.hpp"
+#include "HandlerAllocator.hpp"
+#include "RingQueue.hpp"
+#include "Stats.hpp"
 #include "Logging.hpp"
-#include <queue>
+#include <vector>
+#include <array>
 #include <memory>
 #include <span>
 #include <atomic>
 
 namespace DrowsyNetwork {
+
+class ConnectionRegistry;
+
+/**
+ * @brief Write lane a packet is queued in
+ *
+ * Each lane is a FIFO of its own. Control packets go out before anything
+ * else, Realtime and Bulk share the rest of every write by weight (see
+ * Socket::SetPriorityWeights()). Packets of the same lane are never
+ * reordered.
+ *
+ * Packets are never split, since that would interleave two messages on
+ * the stream. A Control packet still waits for the write in flight, so
+ * send large payloads as several Bulk packets to keep that wait short.
+ */
+enum class SendPriority : uint8_t {
+    Control,  ///< Heartbeats, acks, kicks - always written first
+    Realtime, ///< Regular traffic (default)
+    Bulk      ///< Large transfers that may wait, like asset pushes
+};
+
+/// Number of SendPriority values
+inline constexpr size_t SendPriorityCount = 3;
+
+/**
+ * @brief What a socket does when its write queue hits the hard limit
+ */
+enum class WriteOverflowPolicy {
+    Disconnect, ///< Drop the connection - the peer can't keep up anyway
+    DropOldest  ///< Discard the oldest queued packets, lowest priority first, until the queue fits again
+};
+
 /**
  * @brief Represents a single TCP connection
  *
@@ -55,11 +92,30 @@ public:
      * @brief Construct socket with I/O context and connected socket
      * @param IOContext The ASIO I/O context for async operations
      * @param Socket Already connected TCP socket (moved)
+     * @param ReadBufferSize Capacity of the receive buffer in bytes
      *
      * The socket should already be connected (usually from Server::OnAccept).
      * Each socket gets a unique ID for logging and identification.
+     *
+     * The receive buffer is allocated once here and never grows, so pick a
+     * size that fits the largest chunk you want OnRead() to see at once.
+     */
+    explicit Socket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket,
+        size_t ReadBufferSize = ReadBuffer::DefaultCapacity);
+
+    /**
+     * @brief Construct socket that borrows read buffers from a shared pool
+     * @param IOContext The ASIO I/O context for async operations
+     * @param Socket Already connected TCP socket (moved)
+     * @param Pool Pool shared with other sockets
+     *
+     * While the socket has nothing buffered it waits for readability
+     * without holding any buffer, and only takes a block from the pool
+     * once data is actually there. Use this for servers with many mostly
+     * idle connections.
      */
-    explicit Socket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket);
+    explicit Socket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket,
+        std::shared_ptr<ReadBufferPool> Pool);
 
     /**
      * @brief Virtual destructor for proper cleanup
@@ -83,18 +139,26 @@ public:
      * @return Unique socket ID (never reused)
      *
      * Useful for logging, tracking, and associating sockets with
-     * application-level data structures.
+     * application-level data structures. Ids are unique but not strictly
+     * increasing - each thread hands them out from its own block.
      */
     uint64_t GetId() const { return m_Id; }
 
+    /**
+     * @brief Get the I/O context this socket's handlers run on
+     * @return The context behind the socket's strand
+     */
+    Executor& GetExecutor() const;
+
     /**
      * @brief Send a packet to the remote peer (thread-safe)
      * @tparam T Packet data type
      * @param Packet Shared pointer to packet to send
+     * @param Priority Write lane to queue the packet in
      *
      * This method is fully thread-safe and can be called from any thread.
      * Packets are queued and sent in order. If called from the socket's
-     * strand thread, the packet is queued directly. Otherwise, it's posted
+     * strand thread, the packet is queued directly. Otherwise, it's handed
      * to the strand for thread-safe handling.
      *
      * The packet will be kept alive until transmission is complete, so
@@ -107,22 +171,46 @@ public:
      * @endcode
      */
     template <PacketConcept T>
-    void Send(const PacketPtr<T>& Packet) {
-        if (m_Strand.running_in_this_thread()) {
-            // Already on the correct thread - queue directly
-            EnqueueSend(Packet);
-        } else {
-            // Post to strand for thread safety
-            asio::post(m_Strand, [self = weak_from_this(), Packet = Packet]() {
-                if (auto socket = self.lock()) {
-                    socket->EnqueueSend(Packet);
-                } else {
-                    LOG_ERROR("Invalid socket at send");
-                }
-            });
-        }
+    void Send(const PacketPtr<T>& Packet, SendPriority Priority = SendPriority::Realtime) {
+        Send(IPacketBasePtr(Packet), Priority);
+    }
+
+    /**
+     * @brief Send a type-erased packet to the remote peer (thread-safe)
+     * @param Packet Packet to send
+     * @param Priority Write lane to queue the packet in
+     *
+     * Same as the typed Send(), for code that only holds IPacketBasePtr
+     * (like BroadcastGroup). When called from a thread running the socket's
+     * context while the strand is idle, the packet is queued right away
+     * instead of going through a post.
+     */
+    void Send(IPacketBasePtr Packet, SendPriority Priority = SendPriority::Realtime);
+
+    /**
+     * @brief Send a packet unless the write queue is backed up (thread-safe)
+     * @tparam T Packet data type
+     * @param Packet Packet to send
+     * @param Priority Write lane to queue the packet in
+     * @return false if the packet was not queued
+     *
+     * Rejects the packet if the socket is inactive or queuing it would go
+     * above the high watermark (or the hard limit, if no watermark is set).
+     * Use this for traffic you can afford to skip, like position updates.
+     */
+    template <PacketConcept T>
+    bool TrySend(const PacketPtr<T>& Packet, SendPriority Priority = SendPriority::Realtime) {
+        return TrySend(IPacketBasePtr(Packet), Priority);
     }
 
+    /**
+     * @brief Type-erased TrySend()
+     * @param Packet Packet to send
+     * @param Priority Write lane to queue the packet in
+     * @return false if the packet was not queued
+     */
+    bool TrySend(IPacketBasePtr Packet, SendPriority Priority = SendPriority::Realtime);
+
     /**
      * @brief Initialize the socket and start reading (call after construction)
      *
@@ -140,6 +228,25 @@ public:
      */
     virtual void Setup();
 
+    /**
+     * @brief Report to a server's counters, then Setup()
+     * @param Counters The accepting server's m_Counters
+     *
+     * The socket's traffic and latencies are added to the server's stats,
+     * and it counts as open there until it disconnects. Call this instead
+     * of Setup() in Server::OnAccept(), before the socket is shared with
+     * other threads:
+     * @code
+     * void OnAccept(std::unique_ptr<TcpSocket>&& socket) override {
+     *     auto client = std::make_shared<MySocket>(m_IoContext, std::move(socket));
+     *     client->Setup(m_Counters);
+     * }
+     * @endcode
+     * A derived class that overrides Setup() needs `using Socket::Setup;`
+     * to keep this overload visible.
+     */
+    void Setup(std::shared_ptr<ServerCounters> Counters);
+
     /**
      * @brief Disconnect the socket gracefully
      *
@@ -162,29 +269,98 @@ public:
      */
     bool IsActive() const;
 
+    /**
+     * @brief Configure how much a single gather write may carry
+     * @param MaxPackets Maximum packets per write (clamped to MaxWriteBuffers)
+     * @param MaxBytes Soft byte budget per write
+     *
+     * Smaller batches give other sockets on the same thread a chance to run
+     * sooner, bigger batches mean fewer syscalls. The defaults work well
+     * for most chat/game style traffic. Call this before Setup().
+     */
+    void SetWriteBatchLimits(size_t MaxPackets, size_t MaxBytes);
+
+    /**
+     * @brief Configure how Realtime and Bulk share a write
+     * @param RealtimeWeight Share of the Realtime lane (at least 1)
+     * @param BulkWeight Share of the Bulk lane (at least 1)
+     *
+     * After all queued Control packets, each gather write's byte budget is
+     * split between Realtime and Bulk by these weights; whatever one lane
+     * doesn't use goes to the other. Each lane always gets at least one
+     * packet per write when it has any, so neither can starve. The default
+     * is 3:1. Call this before Setup().
+     */
+    void SetPriorityWeights(size_t RealtimeWeight, size_t BulkWeight);
+
+    /**
+     * @brief Configure when the write queue counts as backed up
+     * @param LowBytes Queue is drained again at or below this many bytes
+     * @param HighBytes Queue is blocked above this many bytes (0 = no byte watermark)
+     * @param LowPackets Queue is drained again at or below this many packets
+     * @param HighPackets Queue is blocked above this many packets (0 = no packet watermark)
+     *
+     * Crossing a high watermark calls OnWriteBlocked(), getting back under
+     * all low watermarks calls OnWriteDrained(). Everything handed to Send()
+     * and not yet written counts, including the write in flight. Call this
+     * before Setup().
+     */
+    void SetWriteWatermarks(size_t LowBytes, size_t HighBytes, size_t LowPackets = 0, size_t HighPackets = 0);
+
+    /**
+     * @brief Cap the write queue
+     * @param MaxBytes Hard byte limit (0 = unlimited)
+     * @param MaxPackets Hard packet limit (0 = unlimited)
+     * @param Policy What to do once a limit is exceeded
+     *
+     * Unlike the watermarks this is enforced - a peer that stops reading
+     * can't make the server buffer more than this. Unlimited by default.
+     * Call this before Setup().
+     */
+    void SetWriteHardLimit(size_t MaxBytes, size_t MaxPackets = 0,
+        WriteOverflowPolicy Policy = WriteOverflowPolicy::Disconnect);
+
+    /// Bytes handed to Send() and not written yet
+    size_t GetPendingWriteBytes() const { return m_PendingWriteBytes.load(std::memory_order_relaxed); }
+
+    /// Packets handed to Send() and not written yet
+    size_t GetPendingWritePackets() const { return m_PendingWritePackets.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get a snapshot of the socket's counters (thread-safe)
+     * @return Traffic, write latency and queue depth so far
+     *
+     * A handful of relaxed loads - cheap enough to scan every connection
+     * for the hot ones. If the socket was set up with a server's counters,
+     * the same traffic is also counted in Server::GetStats().
+     */
+    SocketStats GetStats() const;
+
+    /// Upper bound for buffers in one gather write. Matches asio's per-call
+    /// iovec limit (which stays below IOV_MAX), so a batch never gets split
+    /// into several writev calls behind our back.
+    static constexpr size_t MaxWriteBuffers = 64;
+
+    /// Default soft byte budget for one gather write
+    static constexpr size_t DefaultWriteBatchBytes = 256 * 1024;
+
+    /// Default Realtime:Bulk split of a gather write
+    static constexpr size_t DefaultRealtimeWeight = 3;
+    static constexpr size_t DefaultBulkWeight = 1;
+
 protected:
     /**
      * @brief Queue a packet for sending (internal, strand-only)
-     * @tparam T Packet data type
-     * @param Packet Shared pointer to packet to queue
+     * @param Packet Packet to queue
+     * @param Priority Write lane to queue the packet in
+     * @param SentAt When Send() was called off the strand (only set while
+     *        tracking latency), unset means now and records no SendDispatch
      *
      * This is the internal implementation of Send(). It must only be
      * called from within the socket's strand thread for thread safety.
      * Use Send() from application code instead.
      */
-    template <PacketConcept T>
-    void EnqueueSend(const PacketPtr<T>& Packet) {
-        if (!IsActive())
-            return;
-
-        m_WriteQueue.push_back(Packet);
-
-        // Start writing if not already in progress
-        if (!m_IsWriting) {
-            m_IsWriting = true;
-            HandleWrite();
-        }
-    }
+    void EnqueueSend(IPacketBasePtr Packet, SendPriority Priority, StatsClock::time_point SentAt = {});
 
     /**
      * @brief Handle disconnection cleanup (override for custom behavior)
@@ -199,9 +375,10 @@ protected:
     /**
      * @brief Start async write operation for queued packets
      *
-     * Begins transmission of the first packet in the write queue.
-     * This method ensures packets are sent in order and handles
-     * the async write completion.
+     * Moves as many queued packets as the batch limits allow into the
+     * in-flight batch and writes all of them with a single gather write.
+     * A burst of small packets therefore costs one writev instead of one
+     * syscall (and one strand round trip) per packet.
      */
     virtual void HandleWrite();
 
@@ -210,32 +387,118 @@ protected:
      * @param ErrorCode Any error that occurred during writing
      * @param BytesTransferred Number of bytes successfully sent
      *
-     * This method is called when a packet has finished sending (or failed).
-     * It removes the completed packet from the queue and starts sending
-     * the next packet if any are queued.
+     * This method is called when the in-flight batch has finished sending
+     * (or failed). It releases every packet of the batch and starts the
+     * next batch if more packets were queued in the meantime.
      */
     virtual void FinishWrite(asio::error_code ErrorCode, std::size_t BytesTransferred);
 
+    /**
+     * @brief Fill the in-flight batch and its buffer sequence
+     *
+     * Called by HandleWrite() with an empty m_WriteBatch and m_Operations->WriteBuffers.
+     * The default implementation takes packets via CollectWriteBatch() and
+     * adds one buffer per packet. Override this if your protocol needs to
+     * add extra buffers (like a length prefix) around each packet.
+     */
+    virtual void PrepareWriteBatch();
+
+    /**
+     * @brief Move packets from the write queue into the in-flight batch
+     * @param MaxPackets Maximum number of packets to take
+     * @return Number of packets moved into m_WriteBatch
+     *
+     * All queued Control packets are taken first, then Realtime and Bulk
+     * split the rest of the byte budget by their weights. Each lane is taken
+     * in order, and the first packet of a lane is always taken, even if it
+     * alone is larger than its share, so oversized packets can't stall it.
+     */
+    size_t CollectWriteBatch(size_t MaxPackets);
+
+    /**
+     * @brief Move packets of one lane into the in-flight batch
+     * @param Priority Lane to take from
+     * @param MaxPackets Batch packet limit
+     * @param MaxBytes Bytes this lane may add
+     * @param TakeFirst Take the first packet even if it's bigger than MaxBytes
+     * @return Bytes added
+     */
+    size_t CollectLane(SendPriority Priority, size_t MaxPackets, size_t MaxBytes, bool TakeFirst);
+
+    /// Whether any lane has packets waiting
+    bool HasQueuedWrites() const;
+
+    /// Packets waiting in all lanes
+    size_t GetQueuedWriteCount() const;
+
+    /**
+     * @brief Stop counting packets that left the queue (strand-only)
+     * @param Packets Number of packets written or dropped
+     * @param Bytes Their total size
+     *
+     * Calls OnWriteDrained() when this gets a blocked queue back under
+     * the low watermarks.
+     */
+    void ReleasePendingWrites(size_t Packets, size_t Bytes);
+
+    /**
+     * @brief Check whether the pending writes are above a high watermark
+     */
+    bool IsAboveHighWatermark() const;
+
+    /**
+     * @brief Apply the overflow policy if the hard limit is exceeded (strand-only)
+     */
+    void EnforceWriteHardLimit();
+
     /**
      * @brief Start async read operation
      *
-     * Begins reading data from the remote peer. This method sets up
-     * an async read that will continue until some data arrives or
+     * Begins reading data from the remote peer straight into the free tail
+     * of m_ReadBuffer. The read completes as soon as any data arrives or
      * an error occurs.
+     *
+     * A pooled socket with an empty buffer hands its block back and waits
+     * for readability instead, see FinishWait().
      */
     virtual void HandleRead();
 
+    /**
+     * @brief Handle readability of a pooled socket
+     * @param ErrorCode Any error that occurred while waiting
+     *
+     * Borrows a block from the pool and reads everything that is available
+     * right now without blocking, then continues like a normal read.
+     */
+    virtual void FinishWait(asio::error_code ErrorCode);
+
     /**
      * @brief Handle completion of async read operation
      * @param ErrorCode Any error that occurred during reading
      * @param BytesTransferred Number of bytes successfully read
      *
-     * This method processes received data by calling OnRead(), then
-     * continues the read loop. It handles connection errors and
-     * manages the read buffer.
+     * This method commits the received bytes to m_ReadBuffer, hands all
+     * unread data to OnRead(), then continues the read loop. It handles
+     * connection errors and manages the read buffer.
      */
     virtual void FinishRead(asio::error_code ErrorCode, std::size_t BytesTransferred);
 
+    /**
+     * @brief Hand unread data to the application
+     * @param Data Pointer to the first unread byte in m_ReadBuffer
+     * @param Size Number of unread bytes
+     * @return Number of bytes that were used and can be dropped
+     *
+     * Called by FinishRead() after every successful read. Bytes that aren't
+     * reported as used stay in the buffer and are passed again, together
+     * with newly received data, after the next read. The default
+     * implementation hands everything to OnRead() and drops it.
+     *
+     * Override this to parse a protocol directly out of the read buffer
+     * (see FramedSocket) instead of copying partial messages around.
+     */
+    virtual size_t ProcessRead(const uint8_t* Data, size_t Size);
+
     /**
      * @brief Process received data (override this in your derived class)
      * @param Data Pointer to received bytes
@@ -281,7 +544,8 @@ protected:
      *
      * This method is called after the socket has been fully disconnected
      * and cleaned up. Use this for application-level cleanup like removing
-     * the socket from collections, notifying other systems, etc.
+     * the socket from collections, notifying other systems, etc. If the
+     * socket was added to a ConnectionRegistry, it's already gone from it.
      *
      * The socket is guaranteed to be inactive when this is called.
      *
@@ -295,6 +559,21 @@ protected:
      */
     virtual void OnDisconnect() = 0;
 
+    /**
+     * @brief The write queue went above a high watermark
+     *
+     * Called on the socket's strand. Stop producing for this peer (or
+     * switch to TrySend()) until OnWriteDrained() is called.
+     */
+    virtual void OnWriteBlocked() {}
+
+    /**
+     * @brief The write queue is back at or below the low watermarks
+     *
+     * Called on the socket's strand after OnWriteBlocked().
+     */
+    virtual void OnWriteDrained() {}
+
     /**
      * @brief Check if an error code represents a fatal connection error
      * @param ErrorCode The error code to check
@@ -306,13 +585,77 @@ protected:
      */
     static bool IsFatalError(const asio::error_code& ErrorCode);
 
+    /**
+     * @brief Memory pending operations use, kept apart from the socket
+     *
+     * Handlers only hold a weak reference to the socket, so the socket may
+     * be destroyed while a read or write is still pending. The aborted
+     * operation then completes later and still lives in (and reads) this
+     * state, so every handler keeps its own reference to it.
+     *
+     * With io_uring the kernel also owns the memory a submitted operation
+     * points at - the read buffer and the packets of the write in flight -
+     * until the completion arrives, not just until close() cancels it. So
+     * those live here as well, and the socket only refers to them.
+     */
+    struct OperationState {
+        explicit OperationState(size_t ReadBufferSize) : Read(ReadBufferSize) {}
+        explicit OperationState(std::shared_ptr<ReadBufferPool> Pool) : Read(std::move(Pool)) {}
+
+        HandlerMemory ReadMemory;             ///< Reused by every read/wait operation
+        HandlerMemory WriteMemory;            ///< Reused by every write operation
+        ReadBuffer Read;                      ///< Buffer pending reads receive into
+        std::vector<IPacketBasePtr> WriteBatch; ///< Packets of the write in flight
+        std::vector<ConstBuffer> WriteBuffers; ///< Buffer sequence of the write in flight
+        std::vector<uint8_t> WriteScratch;    ///< Extra bytes WriteBuffers point at (e.g. frame prefixes)
+    };
+
+private:
+    friend class ConnectionRegistry;
+
+    /// A packet waiting in a write lane
+    struct QueuedPacket {
+        IPacketBasePtr Packet;        ///< The packet itself
+        StatsClock::time_point SentAt; ///< When Send() was called (only set while tracking latency)
+    };
+
+    /// Record one latency sample per packet of the write in flight
+    void RecordBatchLatency(LatencyMetric Metric, StatsClock::time_point Now);
+
+    /// Count the socket as closed in m_ServerCounters, once
+    void CountClose();
+
 public:
-    Strand<ExecutorType> m_Strand;      ///< Strand for thread-safe operations
+    SocketExecutor m_Strand;            ///< Strand (or plain executor in single-threaded builds) for thread-safe operations
     std::unique_ptr<TcpSocket> m_Socket;    ///< The underlying ASIO socket
     uint64_t m_Id;                      ///< Unique socket identifier
     bool m_IsActive;                    ///< Current connection status
-    std::deque<IPacketBasePtr> m_WriteQueue; ///< Outgoing packet queue
-    asio::streambuf m_ReadBuffer;       ///< Buffer for incoming data
+    std::shared_ptr<OperationState> m_Operations; ///< Co-owned by every pending operation
+    std::array<RingQueue<QueuedPacket>, SendPriorityCount> m_WriteQueues; ///< Outgoing packet queue per SendPriority
+    std::vector<IPacketBasePtr>& m_WriteBatch; ///< Packets of the write in flight (in m_Operations)
+    std::vector<StatsClock::time_point> m_WriteBatchSentAt; ///< Send() times of m_WriteBatch (while tracking latency)
+    size_t m_MaxWriteBatchPackets;      ///< Packet limit per gather write
+    size_t m_MaxWriteBatchBytes;        ///< Soft byte budget per gather write
+    size_t m_WriteBatchBytes;           ///< Payload bytes of the write in flight
+    size_t m_RealtimeWeight;            ///< Realtime share of a write
+    size_t m_BulkWeight;                ///< Bulk share of a write
+    std::atomic<size_t> m_PendingWriteBytes;   ///< Bytes sent but not written yet
+    std::atomic<size_t> m_PendingWritePackets; ///< Packets sent but not written yet
+    size_t m_LowWatermarkBytes;         ///< Drained at or below this many bytes
+    size_t m_HighWatermarkBytes;        ///< Blocked above this many bytes (0 = off)
+    size_t m_LowWatermarkPackets;       ///< Drained at or below this many packets
+    size_t m_HighWatermarkPackets;      ///< Blocked above this many packets (0 = off)
+    size_t m_MaxPendingBytes;           ///< Hard byte limit (0 = unlimited)
+    size_t m_MaxPendingPackets;         ///< Hard packet limit (0 = unlimited)
+    WriteOverflowPolicy m_OverflowPolicy; ///< What happens above the hard limit
+    bool m_IsWriteBlocked;              ///< OnWriteBlocked() called, OnWriteDrained() not yet
+    SocketCounters m_Counters;          ///< Traffic counters, written on the strand only
+    std::shared_ptr<ServerCounters> m_ServerCounters; ///< Counters passed to Setup(), if any
+    StatsClock::time_point m_WriteStartTime; ///< When the write in flight was started
+    bool m_TrackLatency;                ///< Report latencies to m_ServerCounters (fixed at Setup())
+    bool m_IsCountedOpen;               ///< Counted as open in m_ServerCounters, not as closed yet
+    ReadBuffer& m_ReadBuffer;           ///< Fixed-capacity (or pooled) buffer for incoming data (in m_Operations)
     bool m_IsWriting;                   ///< Flag to prevent overlapping writes
+    std::atomic<ConnectionRegistry*> m_Registry; ///< Registry to leave on disconnect, if any
 };
 } // namespace DrowsyNetwork
\ No newline at end of file
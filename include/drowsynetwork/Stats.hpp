@@ -0,0 +1,319 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace DrowsyNetwork {
+
+/// Clock used for all timestamps and durations in the stats
+using StatsClock = std::chrono::steady_clock;
+
+/// Number of slots shared counters are split into - threads beyond this share slots
+inline constexpr size_t StatsSlotCount = 16;
+
+/**
+ * @brief Slot of the calling thread, assigned round-robin on first use
+ * @return Index below StatsSlotCount
+ */
+size_t GetStatsThreadSlot();
+
+/**
+ * @brief Point-in-time copy of a LatencyHistogram
+ *
+ * Values are bucketed HDR-style: exact below 8ns, above that every power of
+ * two is split into 8 buckets, so any reported value is within 12.5% of the
+ * real one.
+ */
+struct HistogramSnapshot {
+    /// Buckets per power of two
+    static constexpr size_t SubBucketBits = 3;
+    static constexpr size_t SubBuckets = size_t(1) << SubBucketBits;
+
+    /// Number of buckets, covering 0 to ~18 minutes in nanoseconds (larger values land in the last one)
+    static constexpr size_t BucketCount = 312;
+
+    std::array<uint64_t, BucketCount> Buckets{}; ///< Recorded values per bucket
+    uint64_t Count = 0;                          ///< Recorded values
+    uint64_t SumNs = 0;                          ///< Sum of all values
+    uint64_t MaxNs = 0;                          ///< Largest value
+
+    /**
+     * @brief Get a percentile
+     * @param Percentile 0 to 100, e.g. 99.9
+     * @return Upper bound of the bucket the percentile falls into (capped at MaxNs), 0 if empty
+     */
+    [[nodiscard]] uint64_t GetPercentileNs(double Percentile) const;
+
+    /// Mean value (0 if empty)
+    [[nodiscard]] uint64_t GetMeanNs() const { return Count ? SumNs / Count : 0; }
+
+    /// Bucket a value is counted in
+    static size_t GetBucket(uint64_t ValueNs);
+
+    /// Largest value counted in a bucket
+    static uint64_t GetBucketUpperBound(size_t Bucket);
+};
+
+/**
+ * @brief Log-bucketed latency histogram that any thread can record into
+ *
+ * Like ServerCounters, the buckets are split into per-thread slots so
+ * recording is one uncontended relaxed add. Snapshot() merges the slots.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @brief Record a duration
+     * @param Duration Measured time (negative values count as 0)
+     */
+    void Record(StatsClock::duration Duration);
+
+    /// Merge all slots
+    [[nodiscard]] HistogramSnapshot Snapshot() const;
+
+private:
+    struct alignas(64) Slot {
+        std::array<std::atomic<uint64_t>, HistogramSnapshot::BucketCount> Buckets{};
+        std::atomic<uint64_t> Count{0};
+        std::atomic<uint64_t> SumNs{0};
+        std::atomic<uint64_t> MaxNs{0};
+    };
+
+    std::array<Slot, StatsSlotCount> m_Slots;
+};
+
+/**
+ * @brief Where a socket's time goes, see Server::GetLatency()
+ */
+enum class LatencyMetric : size_t {
+    SendDispatch, ///< Send() from off the strand until the packet is queued on it (strand contention)
+    SendQueue,    ///< Send() until the packet's write starts (dispatch plus waiting in the write queue)
+    SendToWire,   ///< Send() until the packet's write completed
+    ReadHandler,  ///< Read completion until ProcessRead()/OnRead() returned (handler time)
+    Count
+};
+
+/**
+ * @brief Point-in-time copy of a socket's counters
+ *
+ * Counters only ever grow. To get rates, take two snapshots and divide the
+ * difference by the difference of their Time.
+ */
+struct SocketStats {
+    StatsClock::time_point Time;    ///< When the snapshot was taken
+    uint64_t BytesReceived = 0;     ///< Bytes read from the peer
+    uint64_t BytesSent = 0;         ///< Bytes written to the peer (framing included)
+    uint64_t PacketsSent = 0;       ///< Packets fully written
+    uint64_t Reads = 0;             ///< Completed read operations
+    uint64_t Writes = 0;            ///< Completed gather writes
+    uint64_t WriteTimeTotalNs = 0;  ///< Sum of write durations (start to completion)
+    uint64_t WriteTimeMaxNs = 0;    ///< Longest single write
+    size_t PendingWriteBytes = 0;   ///< Bytes handed to Send() and not written yet
+    size_t PendingWritePackets = 0; ///< Packets handed to Send() and not written yet
+
+    /// Mean write duration in nanoseconds (0 before the first write)
+    [[nodiscard]] uint64_t GetAverageWriteTimeNs() const { return Writes ? WriteTimeTotalNs / Writes : 0; }
+};
+
+/**
+ * @brief Point-in-time sum over everything a server accepted
+ */
+struct ServerStats {
+    StatsClock::time_point Time;    ///< When the snapshot was taken
+    uint64_t Accepted = 0;          ///< Connections accepted
+    uint64_t AcceptErrors = 0;      ///< Failed accepts
+    uint64_t SocketsOpened = 0;     ///< Sockets set up with the server's counters
+    uint64_t SocketsClosed = 0;     ///< Of those, sockets disconnected again
+    uint64_t BytesReceived = 0;     ///< Bytes read by all sockets
+    uint64_t BytesSent = 0;         ///< Bytes written by all sockets
+    uint64_t PacketsSent = 0;       ///< Packets written by all sockets
+    uint64_t Reads = 0;             ///< Read operations of all sockets
+    uint64_t Writes = 0;            ///< Gather writes of all sockets
+    uint64_t PendingWriteBytes = 0; ///< Bytes handed to Send() and not written yet, over all sockets
+    uint64_t PendingWritePackets = 0; ///< Packets handed to Send() and not written yet, over all sockets
+
+    /// Sockets currently connected
+    [[nodiscard]] uint64_t GetOpenSockets() const { return SocketsOpened - SocketsClosed; }
+};
+
+/**
+ * @brief Live counters of one socket
+ *
+ * Only the socket's strand writes them, so an update is a relaxed load and
+ * store - no locked instruction, no contention. Any thread may take a
+ * Snapshot() at any time.
+ */
+class SocketCounters {
+public:
+    void RecordRead(size_t Bytes) {
+        Increase(m_BytesReceived, Bytes);
+        Increase(m_Reads, 1);
+    }
+
+    void RecordWrite(size_t Bytes, size_t Packets, uint64_t DurationNs) {
+        Increase(m_BytesSent, Bytes);
+        Increase(m_PacketsSent, Packets);
+        Increase(m_Writes, 1);
+        Increase(m_WriteTimeTotalNs, DurationNs);
+        if (DurationNs > m_WriteTimeMaxNs.load(std::memory_order_relaxed))
+            m_WriteTimeMaxNs.store(DurationNs, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copy the counters
+     * @return Snapshot without the pending-write fields (the socket fills those in)
+     */
+    [[nodiscard]] SocketStats Snapshot() const {
+        SocketStats Stats;
+        Stats.Time = StatsClock::now();
+        Stats.BytesReceived = m_BytesReceived.load(std::memory_order_relaxed);
+        Stats.BytesSent = m_BytesSent.load(std::memory_order_relaxed);
+        Stats.PacketsSent = m_PacketsSent.load(std::memory_order_relaxed);
+        Stats.Reads = m_Reads.load(std::memory_order_relaxed);
+        Stats.Writes = m_Writes.load(std::memory_order_relaxed);
+        Stats.WriteTimeTotalNs = m_WriteTimeTotalNs.load(std::memory_order_relaxed);
+        Stats.WriteTimeMaxNs = m_WriteTimeMaxNs.load(std::memory_order_relaxed);
+        return Stats;
+    }
+
+private:
+    /// Single writer, so no read-modify-write needed
+    static void Increase(std::atomic<uint64_t>& Counter, uint64_t Value) {
+        Counter.store(Counter.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_BytesReceived{0};
+    std::atomic<uint64_t> m_BytesSent{0};
+    std::atomic<uint64_t> m_PacketsSent{0};
+    std::atomic<uint64_t> m_Reads{0};
+    std::atomic<uint64_t> m_Writes{0};
+    std::atomic<uint64_t> m_WriteTimeTotalNs{0};
+    std::atomic<uint64_t> m_WriteTimeMaxNs{0};
+};
+
+/**
+ * @brief How often accepting failed with one particular error
+ */
+struct AcceptErrorCount {
+    std::string Category; ///< Error category name, e.g. "system"
+    int Code = 0;         ///< Error value within the category
+    std::string Message;  ///< Human readable description
+    uint64_t Count = 0;   ///< Failed accepts with this error
+};
+
+/**
+ * @brief Live counters of one server and all its sockets
+ *
+ * Sockets on many threads update these at once. To keep them from fighting
+ * over one cache line, the counters are split into slots and every thread
+ * sticks to one slot. Snapshot() adds the slots up.
+ *
+ * Sockets report to the counters they were given in Socket::Setup(), see
+ * Server::OnAccept().
+ */
+class ServerCounters {
+public:
+    /// Counters kept per slot
+    enum Counter : size_t {
+        Accepted,
+        AcceptErrors,
+        SocketsOpened,
+        SocketsClosed,
+        BytesReceived,
+        BytesSent,
+        PacketsSent,
+        Reads,
+        Writes,
+        PendingWriteBytes,   ///< Gauge - added on Send(), subtracted once written or dropped
+        PendingWritePackets, ///< Gauge - same as PendingWriteBytes
+        Connections,         ///< Gauge - added when Server admits a connection, subtracted when its socket disconnects
+        CounterCount
+    };
+
+    /**
+     * @brief Add to a counter in the calling thread's slot
+     * @param Which Counter to increase
+     * @param Value Amount to add
+     */
+    void Add(Counter Which, uint64_t Value) {
+        m_Slots[GetStatsThreadSlot()].Values[Which].fetch_add(Value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Take from a gauge in the calling thread's slot
+     * @param Which Gauge to decrease
+     * @param Value Amount to take
+     *
+     * A slot may wrap below zero when another thread added the value, the
+     * sum over all slots is still right.
+     */
+    void Subtract(Counter Which, uint64_t Value) {
+        m_Slots[GetStatsThreadSlot()].Values[Which].fetch_sub(Value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Count a failed accept
+     * @param ErrorCode Why it failed
+     *
+     * Increases AcceptErrors and the per-error count. Takes a lock, which is
+     * fine on this (rare) path.
+     */
+    void RecordAcceptError(const std::error_code& ErrorCode);
+
+    /// Failed accepts per error, in order of first occurrence
+    [[nodiscard]] std::vector<AcceptErrorCount> GetAcceptErrors() const;
+
+    /// Sum up all slots
+    [[nodiscard]] ServerStats Snapshot() const;
+
+    /// Sum of one counter over all slots, cheaper than a full Snapshot()
+    [[nodiscard]] uint64_t Get(Counter Which) const {
+        uint64_t Total = 0;
+        for (const auto& Entry : m_Slots) {
+            Total += Entry.Values[Which].load(std::memory_order_relaxed);
+        }
+        return Total;
+    }
+
+    /**
+     * @brief Record a latency sample
+     * @param Metric What was measured
+     * @param Duration Measured time
+     */
+    void RecordLatency(LatencyMetric Metric, StatsClock::duration Duration) {
+        m_Latencies[static_cast<size_t>(Metric)].Record(Duration);
+    }
+
+    /// Snapshot of one latency histogram
+    [[nodiscard]] HistogramSnapshot GetLatency(LatencyMetric Metric) const {
+        return m_Latencies[static_cast<size_t>(Metric)].Snapshot();
+    }
+
+    /// Whether sockets should timestamp their packets and reads (off until SetTrackingLatency(true))
+    [[nodiscard]] bool IsTrackingLatency() const { return m_TrackLatency.load(std::memory_order_relaxed); }
+
+    /// Turn latency tracking for sockets created from now on on or off
+    void SetTrackingLatency(bool Enabled) { m_TrackLatency.store(Enabled, std::memory_order_relaxed); }
+
+private:
+    /// One thread's (or a few threads') counters, on their own cache line
+    struct alignas(64) Slot {
+        std::array<std::atomic<uint64_t>, CounterCount> Values{};
+    };
+
+    std::array<Slot, StatsSlotCount> m_Slots;
+    std::array<LatencyHistogram, static_cast<size_t>(LatencyMetric::Count)> m_Latencies;
+    std::atomic<bool> m_TrackLatency{false};
+
+    mutable std::mutex m_AcceptErrorMutex;         ///< Guards m_AcceptErrors
+    std::vector<AcceptErrorCount> m_AcceptErrors; ///< Failed accepts per error
+};
+
+} // namespace DrowsyNetwork
@@ -0,0 +1,336 @@
+#include "drowsynetwork/AsyncLogger.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+namespace DrowsyNetwork {
+
+namespace {
+    using LogClock = std::chrono::steady_clock;
+    using FormatFunction = void (*)(std::string& Out, std::string_view Format, void* Arguments);
+
+    /// One queued log line
+    struct LogRecord {
+        LogClock::time_point Time;
+        std::string_view Format;
+        FormatFunction Writer;
+        alignas(std::max_align_t) std::byte Arguments[AsyncLogger::InlineArgumentSize];
+    };
+
+    /// Rate limit state of one call site on one thread
+    struct LogSite {
+        const char* Format = nullptr;
+        LogClock::time_point WindowStart;
+        uint32_t Count = 0;
+        uint32_t Suppressed = 0;
+    };
+
+    /**
+     * @brief Single-producer single-consumer ring of one logging thread
+     *
+     * The owning thread writes m_Tail, the flusher (under the drain mutex)
+     * writes m_Head. Neither ever waits for the other.
+     */
+    class LogRing {
+    public:
+        static constexpr size_t SiteCount = 64;
+
+        /// Producer: slot for the next record, nullptr if full
+        LogRecord* Reserve() {
+            const auto Tail = m_Tail.load(std::memory_order_relaxed);
+            if (Tail - m_Head.load(std::memory_order_acquire) == AsyncLogger::RingCapacity)
+                return nullptr;
+
+            return &m_Records[Tail % AsyncLogger::RingCapacity];
+        }
+
+        /// Producer: publish the reserved record
+        void Commit() {
+            m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /// Consumer: format and release every published record
+        template<typename FunctionType>
+        void Drain(FunctionType&& Function) {
+            const auto Tail = m_Tail.load(std::memory_order_acquire);
+            auto Head = m_Head.load(std::memory_order_relaxed);
+            for (; Head != Tail; ++Head) {
+                Function(m_Records[Head % AsyncLogger::RingCapacity]);
+            }
+
+            m_Head.store(Head, std::memory_order_release);
+        }
+
+        /// Producer: rate limit state of a call site (sites sharing a slot simply reset each other)
+        LogSite& GetSite(const char* Format) {
+            return m_Sites[(reinterpret_cast<uintptr_t>(Format) >> 3) % SiteCount];
+        }
+
+        [[nodiscard]] bool IsEmpty() const {
+            return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+        }
+
+        std::atomic<bool> Abandoned{false}; ///< Owning thread has exited
+
+    private:
+        std::array<LogRecord, AsyncLogger::RingCapacity> m_Records;
+        std::array<LogSite, SiteCount> m_Sites;
+        alignas(64) std::atomic<size_t> m_Head{0};
+        alignas(64) std::atomic<size_t> m_Tail{0};
+    };
+
+    /// Process-wide logger state, never destroyed so logging works during static destruction
+    /// (a thread whose ring is already gone writes synchronously, see t_RingDestroyed)
+    struct LoggerState {
+        std::mutex RingsMutex;
+        std::vector<std::shared_ptr<LogRing>> Rings;
+
+        std::mutex DrainMutex;
+        AsyncLogger::Sink Output;
+        uint64_t ReportedDrops = 0;
+
+        std::once_flag StartFlag;
+        std::thread Flusher;
+        std::mutex StopMutex;
+        std::condition_variable StopCondition;
+        bool StopRequested = false;
+        std::atomic<bool> Stopped{false};
+
+        std::atomic<uint32_t> RateLimit{AsyncLogger::DefaultRateLimit};
+        std::atomic<uint64_t> Dropped{0};
+    };
+
+    LoggerState& GetState() {
+        static auto* s_State = new LoggerState();
+        return *s_State;
+    }
+
+    void WriteToStdout(std::string_view Text) {
+        std::fwrite(Text.data(), 1, Text.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    /// Hand text to the sink, the drain mutex must be held
+    void WriteToSink(LoggerState& State, std::string_view Text) {
+        if (State.Output) {
+            State.Output(Text);
+        } else {
+            WriteToStdout(Text);
+        }
+    }
+
+    void DrainRings() {
+        auto& State = GetState();
+        std::lock_guard<std::mutex> DrainLock(State.DrainMutex);
+
+        std::vector<std::shared_ptr<LogRing>> Rings;
+        {
+            std::lock_guard<std::mutex> Lock(State.RingsMutex);
+            // Rings of exited threads go once they're empty - their records are drained below
+            std::erase_if(State.Rings, [](const auto& Ring) {
+                return Ring->Abandoned.load(std::memory_order_acquire) && Ring->IsEmpty();
+            });
+            Rings = State.Rings;
+        }
+
+        std::vector<std::pair<LogClock::time_point, std::string>> Lines;
+        for (const auto& Ring : Rings) {
+            Ring->Drain([&](LogRecord& Record) {
+                auto& Line = Lines.emplace_back(Record.Time, std::string()).second;
+                Record.Writer(Line, Record.Format, Record.Arguments);
+            });
+        }
+
+        const auto Dropped = State.Dropped.load(std::memory_order_relaxed);
+        if (Lines.empty() && Dropped == State.ReportedDrops)
+            return;
+
+        // Each ring is in order already, this interleaves the threads
+        std::ranges::stable_sort(Lines, {}, [](const auto& Line) { return Line.first; });
+
+        std::string Text;
+        for (const auto& Line : Lines | std::views::values) {
+            Text += Line;
+            Text += '\n';
+        }
+
+        if (Dropped != State.ReportedDrops) {
+            Text += std::format("[WARN] Log rings were full, dropped {} messages\n", Dropped - State.ReportedDrops);
+            State.ReportedDrops = Dropped;
+        }
+
+        WriteToSink(State, Text);
+    }
+
+    void StopFlusher() {
+        auto& State = GetState();
+        {
+            std::lock_guard<std::mutex> Lock(State.StopMutex);
+            State.StopRequested = true;
+        }
+        State.StopCondition.notify_one();
+
+        if (State.Flusher.joinable())
+            State.Flusher.join();
+
+        // From here on every message is written synchronously
+        State.Stopped.store(true, std::memory_order_release);
+        DrainRings();
+    }
+
+    void StartFlusher() {
+        auto& State = GetState();
+        State.Flusher = std::thread([&State] {
+            std::unique_lock<std::mutex> Lock(State.StopMutex);
+            while (!State.StopRequested) {
+                State.StopCondition.wait_for(Lock, AsyncLogger::FlushInterval, [&State] { return State.StopRequested; });
+
+                Lock.unlock();
+                DrainRings();
+                Lock.lock();
+            }
+        });
+
+        std::atexit(StopFlusher);
+    }
+
+    /// Set once the thread's ring handle is destroyed - messages logged during
+    /// thread or static teardown after that are formatted and written on the spot
+    thread_local bool t_RingDestroyed = false;
+
+    /// Record of a message logged after the ring is gone, trivially destructible so it outlives t_RingDestroyed
+    thread_local LogRecord t_LateRecord;
+    static_assert(std::is_trivially_destructible_v<LogRecord>);
+
+    /// The calling thread's ring, registered on first use
+    LogRing& GetThreadRing() {
+        struct RingHandle {
+            RingHandle() : Ring(std::make_shared<LogRing>()) {
+                auto& State = GetState();
+                {
+                    std::lock_guard<std::mutex> Lock(State.RingsMutex);
+                    State.Rings.push_back(Ring);
+                }
+
+                std::call_once(State.StartFlag, StartFlusher);
+            }
+
+            ~RingHandle() {
+                t_RingDestroyed = true;
+                Ring->Abandoned.store(true, std::memory_order_release);
+            }
+
+            std::shared_ptr<LogRing> Ring;
+        };
+
+        thread_local RingHandle t_Handle;
+        return *t_Handle.Ring;
+    }
+
+    /// Notice for messages a call site had suppressed in its last window
+    using SuppressedNotice = std::tuple<uint32_t, std::string_view>;
+}
+
+void AsyncLogger::FormatText(std::string& Out, std::string_view, void* Arguments) {
+    using Text = std::tuple<std::string>;
+    auto& Values = *static_cast<Text*>(Arguments);
+    Out += std::get<0>(Values);
+    Values.~Text();
+}
+
+void* AsyncLogger::Reserve(std::string_view Format, FormatFunction Writer) {
+    // No ring to queue into anymore - Commit() writes this one right away
+    if (t_RingDestroyed) {
+        t_LateRecord.Format = Format;
+        t_LateRecord.Writer = Writer;
+        return t_LateRecord.Arguments;
+    }
+
+    auto& State = GetState();
+    auto& Ring = GetThreadRing();
+    const auto Now = LogClock::now();
+
+    if (const auto Limit = State.RateLimit.load(std::memory_order_relaxed)) {
+        auto& Site = Ring.GetSite(Format.data());
+        if (Site.Format != Format.data()) {
+            Site = LogSite{ Format.data(), Now, 0, 0 };
+        } else if (Now - Site.WindowStart >= std::chrono::seconds(1)) {
+            const auto Suppressed = std::exchange(Site.Suppressed, 0);
+            Site.WindowStart = Now;
+            Site.Count = 0;
+
+            if (Suppressed) {
+                if (auto* Notice = Ring.Reserve()) {
+                    Notice->Time = Now;
+                    Notice->Format = "[WARN] Suppressed {} repeats of \"{}\"";
+                    Notice->Writer = &FormatRecord<SuppressedNotice>;
+                    ::new (Notice->Arguments) SuppressedNotice(Suppressed, Format);
+                    Ring.Commit();
+                }
+            }
+        }
+
+        if (++Site.Count > Limit) {
+            ++Site.Suppressed;
+            return nullptr;
+        }
+    }
+
+    auto* Record = Ring.Reserve();
+    if (!Record) {
+        State.Dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Record->Time = Now;
+    Record->Format = Format;
+    Record->Writer = Writer;
+    return Record->Arguments;
+}
+
+void AsyncLogger::Commit() {
+    if (t_RingDestroyed) {
+        std::string Line;
+        t_LateRecord.Writer(Line, t_LateRecord.Format, t_LateRecord.Arguments);
+        Line += '\n';
+
+        // Whatever the other threads still have queued goes first
+        DrainRings();
+
+        auto& State = GetState();
+        std::lock_guard<std::mutex> DrainLock(State.DrainMutex);
+        WriteToSink(State, Line);
+        return;
+    }
+
+    GetThreadRing().Commit();
+
+    // The flusher is gone during exit - write right away instead
+    if (GetState().Stopped.load(std::memory_order_acquire))
+        DrainRings();
+}
+
+void AsyncLogger::Flush() {
+    DrainRings();
+}
+
+void AsyncLogger::SetSink(Sink Output) {
+    auto& State = GetState();
+    std::lock_guard<std::mutex> Lock(State.DrainMutex);
+    State.Output = std::move(Output);
+}
+
+void AsyncLogger::SetRateLimit(uint32_t MessagesPerSecond) {
+    GetState().RateLimit.store(MessagesPerSecond, std::memory_order_relaxed);
+}
+
+uint64_t AsyncLogger::GetDroppedCount() {
+    return GetState().Dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace DrowsyNetwork
@@ -0,0 +1,96 @@
+#include "drowsynetwork/BroadcastGroup.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace DrowsyNetwork {
+
+void BroadcastGroup::Add(const std::shared_ptr<Socket>& Member) {
+    if (!Member)
+        return;
+
+    auto* Context = &Member->GetExecutor();
+
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    if (m_Locations.contains(Member->GetId()))
+        return;
+
+    auto It = std::find_if(m_Buckets.begin(), m_Buckets.end(), [Context](const Bucket& Entry) {
+        return Entry.Context == Context;
+    });
+    if (It == m_Buckets.end()) {
+        It = m_Buckets.insert(m_Buckets.end(), Bucket{ Context, std::make_shared<MemberList>() });
+    }
+
+    auto& Members = Modify(*It);
+    const auto BucketIndex = static_cast<size_t>(It - m_Buckets.begin());
+    m_Locations.emplace(Member->GetId(), Location{ BucketIndex, Members.size() });
+    Members.push_back(Member);
+}
+
+bool BroadcastGroup::Remove(uint64_t Id) {
+    std::shared_ptr<Socket> Removed;
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        auto It = m_Locations.find(Id);
+        if (It == m_Locations.end())
+            return false;
+
+        const auto [BucketIndex, Index] = It->second;
+        m_Locations.erase(It);
+
+        // Swap-remove keeps the member array contiguous
+        auto& Members = Modify(m_Buckets[BucketIndex]);
+        Removed = std::move(Members[Index]);
+        if (Index != Members.size() - 1) {
+            Members[Index] = std::move(Members.back());
+            m_Locations[Members[Index]->GetId()].Index = Index;
+        }
+        Members.pop_back();
+    }
+
+    // Removed may be the last reference - let it go outside the lock
+    return true;
+}
+
+bool BroadcastGroup::Contains(uint64_t Id) const {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Locations.contains(Id);
+}
+
+size_t BroadcastGroup::GetSize() const {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Locations.size();
+}
+
+BroadcastGroup::MemberList& BroadcastGroup::Modify(Bucket& Entry) {
+    // References are only taken under m_Mutex, so a count of one can't go up behind our back
+    if (Entry.Members.use_count() > 1) {
+        Entry.Members = std::make_shared<MemberList>(*Entry.Members);
+    } else {
+        // Pairs with the release in the last broadcast's shared_ptr drop - it's done reading
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    return *Entry.Members;
+}
+
+void BroadcastGroup::Broadcast(const IPacketBasePtr& Packet, SendPriority Priority) {
+    if (!Packet)
+        return;
+
+    // One reference per context, not per member - posting is cheap enough to do under the lock
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    for (const auto& Entry : m_Buckets) {
+        if (Entry.Members->empty())
+            continue;
+
+        // One post per context, the members are then served back to back on it
+        asio::post(*Entry.Context, BindRecyclingAllocator([Members = std::shared_ptr<const MemberList>(Entry.Members), Packet, Priority]() {
+            for (const auto& Member : *Members) {
+                Member->Send(Packet, Priority);
+            }
+        }));
+    }
+}
+
+} // namespace DrowsyNetwork
@@ -0,0 +1,92 @@
+#include "drowsynetwork/ConnectionRegistry.hpp"
+#include <algorithm>
+#include <bit>
+#include <ranges>
+
+namespace DrowsyNetwork {
+
+ConnectionRegistry::ConnectionRegistry(size_t ShardCount) :
+    m_ShardMask(std::bit_ceil(std::max<size_t>(ShardCount, 1)) - 1),
+    m_Size(0)
+{
+    m_Shards = std::make_unique<Shard[]>(m_ShardMask + 1);
+}
+
+ConnectionRegistry::~ConnectionRegistry() {
+    for (size_t Index = 0; Index <= m_ShardMask; ++Index) {
+        std::unique_lock Lock(m_Shards[Index].Mutex);
+        for (const auto& Member : m_Shards[Index].Sockets | std::views::values) {
+            ConnectionRegistry* Expected = this;
+            Member->m_Registry.compare_exchange_strong(Expected, nullptr);
+        }
+    }
+}
+
+bool ConnectionRegistry::Add(const std::shared_ptr<Socket>& Connection) {
+    if (!Connection)
+        return false;
+
+    // A socket belongs to at most one registry - that's where it removes itself from
+    ConnectionRegistry* Expected = nullptr;
+    if (!Connection->m_Registry.compare_exchange_strong(Expected, this))
+        return false;
+
+    auto& Target = GetShard(Connection->GetId());
+    {
+        std::unique_lock Lock(Target.Mutex);
+        Target.Sockets.emplace(Connection->GetId(), Connection);
+    }
+
+    m_Size.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ConnectionRegistry::Remove(uint64_t Id) {
+    std::shared_ptr<Socket> Removed;
+
+    auto& Target = GetShard(Id);
+    {
+        std::unique_lock Lock(Target.Mutex);
+        auto It = Target.Sockets.find(Id);
+        if (It == Target.Sockets.end())
+            return false;
+
+        Removed = std::move(It->second);
+        Target.Sockets.erase(It);
+    }
+
+    m_Size.fetch_sub(1, std::memory_order_relaxed);
+
+    // Removed may be the last reference - let it go outside the lock
+    ConnectionRegistry* Expected = this;
+    Removed->m_Registry.compare_exchange_strong(Expected, nullptr);
+    return true;
+}
+
+std::shared_ptr<Socket> ConnectionRegistry::Find(uint64_t Id) const {
+    const auto& Target = GetShard(Id);
+
+    std::shared_lock Lock(Target.Mutex);
+    auto It = Target.Sockets.find(Id);
+    return It != Target.Sockets.end() ? It->second : nullptr;
+}
+
+std::vector<std::shared_ptr<Socket>> ConnectionRegistry::GetSnapshot() const {
+    std::vector<std::shared_ptr<Socket>> Members;
+    Members.reserve(GetSize());
+
+    for (size_t Index = 0; Index <= m_ShardMask; ++Index) {
+        CopyShard(m_Shards[Index], Members);
+    }
+
+    return Members;
+}
+
+void ConnectionRegistry::CopyShard(const Shard& Source, std::vector<std::shared_ptr<Socket>>& Destination) {
+    std::shared_lock Lock(Source.Mutex);
+    for (const auto& Member : Source.Sockets | std::views::values) {
+        Destination.push_back(Member);
+    }
+}
+
+} // namespace DrowsyNetwork
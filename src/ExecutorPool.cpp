@@ -0,0 +1,90 @@
+#include "drowsynetwork/ExecutorPool.hpp"
+#include "drowsynetwork/Logging.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace DrowsyNetwork {
+
+ExecutorPool::ExecutorPool(size_t Size) :
+    m_Next(0)
+{
+    Size = std::max<size_t>(Size, 1);
+
+    m_Executors.reserve(Size);
+    m_WorkGuards.reserve(Size);
+    for (size_t Index = 0; Index < Size; ++Index) {
+        // Concurrency hint 1: each context is only ever run by one thread
+        auto& Context = m_Executors.emplace_back(std::make_unique<Executor>(1));
+        m_WorkGuards.emplace_back(asio::make_work_guard(*Context));
+    }
+}
+
+ExecutorPool::~ExecutorPool() {
+    Stop();
+    Join();
+}
+
+void ExecutorPool::Run(bool PinThreads) {
+    m_Threads.reserve(m_Threads.size() + m_Executors.size());
+
+    for (size_t Index = 0; Index < m_Executors.size(); ++Index) {
+        auto& Thread = m_Threads.emplace_back([Context = m_Executors[Index].get()]() {
+            Context->run();
+        });
+
+#ifdef __linux__
+        if (PinThreads) {
+            cpu_set_t CpuSet;
+            CPU_ZERO(&CpuSet);
+            CPU_SET(Index % CPU_SETSIZE, &CpuSet);
+            if (pthread_setaffinity_np(Thread.native_handle(), sizeof(CpuSet), &CpuSet) != 0) {
+                LOG_WARN("Failed to pin executor thread {} to its core", Index);
+            }
+        }
+#else
+        (void)Thread;
+        (void)PinThreads;
+#endif
+    }
+
+    LOG_DEBUG("Executor pool running {} contexts", m_Executors.size());
+}
+
+void ExecutorPool::Stop() {
+    for (auto& WorkGuard : m_WorkGuards) {
+        WorkGuard.reset();
+    }
+
+    for (auto& Context : m_Executors) {
+        Context->stop();
+    }
+}
+
+void ExecutorPool::Join() {
+    for (auto& Thread : m_Threads) {
+        if (!Thread.joinable())
+            continue;
+
+        // A pool thread can't join itself, let it finish on its own
+        if (Thread.get_id() == std::this_thread::get_id())
+            Thread.detach();
+        else
+            Thread.join();
+    }
+
+    m_Threads.clear();
+}
+
+Executor& ExecutorPool::GetExecutor(size_t Index) {
+    return *m_Executors[Index % m_Executors.size()];
+}
+
+Executor& ExecutorPool::GetNextExecutor() {
+    return GetExecutor(m_Next.fetch_add(1, std::memory_order_relaxed));
+}
+
+} // namespace DrowsyNetwork
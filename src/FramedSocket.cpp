@@ -0,0 +1,95 @@
+#include "drowsynetwork/FramedSocket.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace DrowsyNetwork {
+
+FramedSocket::FramedSocket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket, size_t ReadBufferSize) :
+    DrowsyNetwork::Socket(IOContext, std::move(Socket), ReadBufferSize)
+{
+    m_Operations->WriteScratch.reserve(MaxWriteBatchPackets * HeaderSize);
+}
+
+FramedSocket::FramedSocket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket, std::shared_ptr<ReadBufferPool> Pool) :
+    DrowsyNetwork::Socket(IOContext, std::move(Socket), std::move(Pool))
+{
+    m_Operations->WriteScratch.reserve(MaxWriteBatchPackets * HeaderSize);
+}
+
+size_t FramedSocket::GetMaxMessageSize() const {
+    return m_ReadBuffer.Capacity() > HeaderSize ? m_ReadBuffer.Capacity() - HeaderSize : 0;
+}
+
+size_t FramedSocket::ProcessRead(const uint8_t* Data, size_t Size) {
+    m_Frames.clear();
+
+    size_t Used = 0;
+    bool Invalid = false;
+    while (Size - Used >= HeaderSize) {
+        HeaderType MessageSize;
+        std::memcpy(&MessageSize, Data + Used, HeaderSize);
+
+        if (MessageSize < 0 || static_cast<size_t>(MessageSize) > GetMaxMessageSize()) {
+            LOG_ERROR("Socket {} received invalid message size: {}", m_Id, MessageSize);
+            Invalid = true;
+            break;
+        }
+
+        // Wait for the rest of the message
+        if (Size - Used - HeaderSize < static_cast<size_t>(MessageSize))
+            break;
+
+        m_Frames.push_back({ Data + Used + HeaderSize, static_cast<size_t>(MessageSize) });
+        Used += HeaderSize + static_cast<size_t>(MessageSize);
+    }
+
+    // Messages that arrived before a bad header are still delivered
+    if (!m_Frames.empty())
+        OnMessages(m_Frames);
+
+    if (Invalid)
+        Disconnect();
+
+    return Used;
+}
+
+void FramedSocket::OnMessages(std::span<const FrameView> Frames) {
+    for (const auto& Frame : Frames) {
+        if (!IsActive())
+            break;
+
+        OnMessage(Frame.Data, Frame.Size);
+    }
+}
+
+void FramedSocket::OnMessage(const uint8_t*, size_t Size) {
+    // Only reached if the derived class overrides neither handler - say so once instead of dropping quietly
+    static std::atomic<bool> s_Reported{false};
+    if (!s_Reported.exchange(true, std::memory_order_relaxed))
+        LOG_ERROR("Socket {} dropped a {} byte message: override OnMessage() or OnMessages()", m_Id, Size);
+}
+
+void FramedSocket::PrepareWriteBatch() {
+    const auto Count = CollectWriteBatch(std::min(m_MaxWriteBatchPackets, MaxWriteBatchPackets));
+
+    // Prefixes live next to the batch so they outlive the socket as long as the write does.
+    // Sized once up front - the buffers below point into it
+    auto& Headers = m_Operations->WriteScratch;
+    Headers.resize(Count * HeaderSize);
+
+    for (size_t Index = 0; Index < Count; ++Index) {
+        const auto& Packet = m_WriteBatch[Index];
+        const auto Header = static_cast<HeaderType>(Packet->size());
+        auto* HeaderData = Headers.data() + Index * HeaderSize;
+        std::memcpy(HeaderData, &Header, HeaderSize);
+
+        m_Operations->WriteBuffers.emplace_back(HeaderData, HeaderSize);
+        m_Operations->WriteBuffers.emplace_back(Packet->data(), Packet->size());
+    }
+}
+
+void FramedSocket::OnRead(const uint8_t*, size_t) {
+}
+
+} // namespace DrowsyNetwork
@@ -0,0 +1,240 @@
+#include "drowsynetwork/MetricsExporter.hpp"
+#include "drowsynetwork/Socket.hpp"
+#include "drowsynetwork/PacketBase.hpp"
+#include "drowsynetwork/Logging.hpp"
+#include <array>
+#include <format>
+#include <iterator>
+#include <string_view>
+
+namespace DrowsyNetwork {
+
+namespace {
+    /// Histogram bucket bounds exported to Prometheus: powers of two from ~1us to ~34s
+    constexpr size_t FirstBoundShift = 10;
+    constexpr size_t LastBoundShift = 35;
+
+    constexpr std::array<std::string_view, static_cast<size_t>(LatencyMetric::Count)> LatencyMetricNames = {
+        "send_dispatch",
+        "send_queue",
+        "send_to_wire",
+        "read_handler",
+    };
+
+    /// Everything one server exports, copied once per scrape
+    struct SourceSnapshot {
+        std::string Name;
+        ServerStats Stats;
+        std::vector<AcceptErrorCount> AcceptErrors;
+        std::array<HistogramSnapshot, static_cast<size_t>(LatencyMetric::Count)> Latencies;
+    };
+
+    /// Label values may not contain raw backslashes, quotes or newlines
+    std::string EscapeLabel(std::string_view Value) {
+        std::string Escaped;
+        Escaped.reserve(Value.size());
+        for (const auto Character : Value) {
+            switch (Character) {
+                case '\\': Escaped += "\\\\"; break;
+                case '"':  Escaped += "\\\""; break;
+                case '\n': Escaped += "\\n"; break;
+                default:   Escaped += Character; break;
+            }
+        }
+
+        return Escaped;
+    }
+
+    void WriteHeader(std::string& Out, std::string_view Name, std::string_view Type, std::string_view Help) {
+        std::format_to(std::back_inserter(Out), "# HELP {} {}\n# TYPE {} {}\n", Name, Help, Name, Type);
+    }
+
+    void WriteHistogram(std::string& Out, std::string_view Labels, const HistogramSnapshot& Histogram) {
+        uint64_t Cumulative = 0;
+        size_t Bucket = 0;
+        for (auto Shift = FirstBoundShift; Shift <= LastBoundShift; ++Shift) {
+            // The last histogram bucket below the bound ends exactly at 2^Shift - 1ns
+            const auto LastBucket = HistogramSnapshot::GetBucket((uint64_t(1) << Shift) - 1);
+            for (; Bucket <= LastBucket; ++Bucket) {
+                Cumulative += Histogram.Buckets[Bucket];
+            }
+
+            const auto Bound = static_cast<double>(uint64_t(1) << Shift) / 1e9;
+            std::format_to(std::back_inserter(Out), "drowsynetwork_latency_seconds_bucket{{{},le=\"{}\"}} {}\n", Labels, Bound, Cumulative);
+        }
+
+        // Not Histogram.Count - a sample recorded while the snapshot was taken may be in
+        // the buckets but not in Count yet, and +Inf must never be below a finite bucket
+        for (; Bucket < Histogram.Buckets.size(); ++Bucket) {
+            Cumulative += Histogram.Buckets[Bucket];
+        }
+
+        std::format_to(std::back_inserter(Out), "drowsynetwork_latency_seconds_bucket{{{},le=\"+Inf\"}} {}\n", Labels, Cumulative);
+        std::format_to(std::back_inserter(Out), "drowsynetwork_latency_seconds_sum{{{}}} {}\n", Labels, static_cast<double>(Histogram.SumNs) / 1e9);
+        std::format_to(std::back_inserter(Out), "drowsynetwork_latency_seconds_count{{{}}} {}\n", Labels, Cumulative);
+    }
+}
+
+/**
+ * @brief One HTTP/1.1 connection to the exporter
+ *
+ * Answers every complete request with the current metrics and keeps the
+ * connection open, as Prometheus reuses it for the next scrape - which
+ * may come after the exporter is gone, see SourceList.
+ */
+class MetricsExporter::Connection : public Socket {
+public:
+    Connection(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket, std::shared_ptr<const SourceList> Sources) :
+        DrowsyNetwork::Socket(IOContext, std::move(Socket), MetricsExporter::MaxRequestSize),
+        m_Sources(std::move(Sources)) {}
+
+protected:
+    size_t ProcessRead(const uint8_t* Data, size_t Size) override {
+        const std::string_view Input(reinterpret_cast<const char*>(Data), Size);
+
+        size_t Consumed = 0;
+        while (IsActive()) {
+            const auto HeaderEnd = Input.find("\r\n\r\n", Consumed);
+            if (HeaderEnd == std::string_view::npos)
+                break;
+
+            const auto Request = Input.substr(Consumed, HeaderEnd - Consumed);
+            Respond(Request.substr(0, Request.find("\r\n")));
+            Consumed = HeaderEnd + 4;
+        }
+
+        // A request that can never complete - the buffer is full
+        if (IsActive() && Size - Consumed >= MetricsExporter::MaxRequestSize) {
+            LOG_WARN("Metrics connection {} sent an oversized request, disconnecting", GetId());
+            Disconnect();
+            return Size;
+        }
+
+        return Consumed;
+    }
+
+    void OnRead(const uint8_t*, size_t) override {}
+
+    void OnDisconnect() override {}
+
+private:
+    void Respond(std::string_view RequestLine) {
+        // "GET /metrics HTTP/1.1" - query strings are ignored
+        const auto MethodEnd = RequestLine.find(' ');
+        const auto Method = RequestLine.substr(0, MethodEnd);
+        auto Target = MethodEnd == std::string_view::npos ? std::string_view() : RequestLine.substr(MethodEnd + 1);
+        Target = Target.substr(0, Target.find_first_of(" ?"));
+
+        if (Method != "GET") {
+            Send(CreateResponse("405 Method Not Allowed", "text/plain", "Only GET is supported\n"));
+        } else if (Target != "/metrics") {
+            Send(CreateResponse("404 Not Found", "text/plain", "Metrics are served at /metrics\n"));
+        } else {
+            Send(CreateResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8", m_Sources->Render()));
+        }
+    }
+
+    static IPacketBasePtr CreateResponse(std::string_view Status, std::string_view ContentType, std::string_view Body) {
+        return PacketBase<std::string>::Create(std::format(
+            "HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\n\r\n{}", Status, ContentType, Body.size(), Body));
+    }
+
+    std::shared_ptr<const SourceList> m_Sources; ///< Outlives the exporter if it has to
+};
+
+MetricsExporter::MetricsExporter(Executor& IOContext) :
+    Server(IOContext),
+    m_Sources(std::make_shared<SourceList>())
+{
+}
+
+MetricsExporter::~MetricsExporter() {
+    Stop();
+}
+
+void MetricsExporter::AddServer(std::string Name, const Server& Source) {
+    std::lock_guard<std::mutex> Lock(m_Sources->Mutex);
+    m_Sources->Entries.push_back({ std::move(Name), Source.GetCounters() });
+}
+
+void MetricsExporter::OnAccept(std::unique_ptr<TcpSocket>&& Socket) {
+    auto& Context = GetSocketExecutor(*Socket);
+    auto Client = std::make_shared<Connection>(Context, std::move(Socket), m_Sources);
+    m_Connections.Add(Client);
+    Client->Setup(m_Counters);
+}
+
+std::string MetricsExporter::Render() const {
+    return m_Sources->Render();
+}
+
+std::string MetricsExporter::SourceList::Render() const {
+    std::vector<SourceSnapshot> Snapshots;
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Snapshots.reserve(Entries.size());
+        for (const auto& Entry : Entries) {
+            auto& Snapshot = Snapshots.emplace_back();
+            Snapshot.Name = EscapeLabel(Entry.Name);
+            Snapshot.Stats = Entry.Counters->Snapshot();
+            Snapshot.AcceptErrors = Entry.Counters->GetAcceptErrors();
+            for (size_t Metric = 0; Metric < Snapshot.Latencies.size(); ++Metric) {
+                Snapshot.Latencies[Metric] = Entry.Counters->GetLatency(static_cast<LatencyMetric>(Metric));
+            }
+        }
+    }
+
+    struct Family {
+        std::string_view Name;
+        std::string_view Type;
+        std::string_view Help;
+        uint64_t ServerStats::* Value;
+    };
+
+    static constexpr std::array<Family, 11> Families = {{
+        { "drowsynetwork_accepted_total", "counter", "Connections accepted.", &ServerStats::Accepted },
+        { "drowsynetwork_sockets_opened_total", "counter", "Sockets set up with the server's counters.", &ServerStats::SocketsOpened },
+        { "drowsynetwork_sockets_closed_total", "counter", "Sockets disconnected again.", &ServerStats::SocketsClosed },
+        { "drowsynetwork_received_bytes_total", "counter", "Bytes read from peers.", &ServerStats::BytesReceived },
+        { "drowsynetwork_sent_bytes_total", "counter", "Bytes written to peers.", &ServerStats::BytesSent },
+        { "drowsynetwork_sent_packets_total", "counter", "Packets fully written.", &ServerStats::PacketsSent },
+        { "drowsynetwork_reads_total", "counter", "Completed read operations.", &ServerStats::Reads },
+        { "drowsynetwork_writes_total", "counter", "Completed gather writes.", &ServerStats::Writes },
+        { "drowsynetwork_pending_write_bytes", "gauge", "Bytes handed to Send() and not written yet.", &ServerStats::PendingWriteBytes },
+        { "drowsynetwork_pending_write_packets", "gauge", "Packets handed to Send() and not written yet.", &ServerStats::PendingWritePackets },
+        { "drowsynetwork_accept_errors_total", "counter", "Failed accepts.", &ServerStats::AcceptErrors },
+    }};
+
+    std::string Out;
+    for (const auto& Entry : Families) {
+        WriteHeader(Out, Entry.Name, Entry.Type, Entry.Help);
+        for (const auto& Snapshot : Snapshots) {
+            std::format_to(std::back_inserter(Out), "{}{{server=\"{}\"}} {}\n", Entry.Name, Snapshot.Name, Snapshot.Stats.*Entry.Value);
+        }
+    }
+
+    WriteHeader(Out, "drowsynetwork_open_connections", "gauge", "Sockets currently alive.");
+    for (const auto& Snapshot : Snapshots) {
+        std::format_to(std::back_inserter(Out), "drowsynetwork_open_connections{{server=\"{}\"}} {}\n", Snapshot.Name, Snapshot.Stats.GetOpenSockets());
+    }
+
+    WriteHeader(Out, "drowsynetwork_accept_errors_by_code_total", "counter", "Failed accepts per error code.");
+    for (const auto& Snapshot : Snapshots) {
+        for (const auto& Error : Snapshot.AcceptErrors) {
+            std::format_to(std::back_inserter(Out), "drowsynetwork_accept_errors_by_code_total{{server=\"{}\",category=\"{}\",code=\"{}\",message=\"{}\"}} {}\n",
+                Snapshot.Name, EscapeLabel(Error.Category), Error.Code, EscapeLabel(Error.Message), Error.Count);
+        }
+    }
+
+    WriteHeader(Out, "drowsynetwork_latency_seconds", "histogram", "Send and read latencies, see Server::GetLatency().");
+    for (const auto& Snapshot : Snapshots) {
+        for (size_t Metric = 0; Metric < Snapshot.Latencies.size(); ++Metric) {
+            const auto Labels = std::format("server=\"{}\",metric=\"{}\"", Snapshot.Name, LatencyMetricNames[Metric]);
+            WriteHistogram(Out, Labels, Snapshot.Latencies[Metric]);
+        }
+    }
+
+    return Out;
+}
+
+} // namespace DrowsyNetwork
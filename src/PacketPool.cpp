@@ -0,0 +1,215 @@
+#include "drowsynetwork/PacketPool.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace DrowsyNetwork {
+
+namespace {
+    /// Smallest size class - every request is rounded up to a power of two from here
+    constexpr size_t MinClassSize = 32;
+
+    /// 32, 64, 128, 256, 512
+    constexpr size_t ClassCount = std::countr_zero(PacketPool::MaxPooledSize) - std::countr_zero(MinClassSize) + 1;
+
+    size_t ClassIndex(size_t Size) {
+        const auto Rounded = std::bit_ceil(Size < MinClassSize ? MinClassSize : Size);
+        return std::countr_zero(Rounded) - std::countr_zero(MinClassSize);
+    }
+
+    size_t ClassSize(size_t Index) {
+        return MinClassSize << Index;
+    }
+
+    /// Intrusive free list node, lives inside the freed block itself
+    struct FreeBlock {
+        FreeBlock* Next;
+    };
+
+    struct Heap;
+
+    /// In front of every pooled block - padded so the object keeps the heap's alignment
+    struct alignas(std::max_align_t) BlockHeader {
+        Heap* Owner; ///< Heap whose free lists the block goes back to, nullptr for the plain heap
+    };
+
+    /**
+     * @brief Free lists of one thread
+     *
+     * The owning thread pops and pushes Local without any synchronization.
+     * Other threads push the blocks they free onto Remote, a lock-free
+     * stack per class, and the owner takes the whole stack at once when its
+     * local list runs dry. So a packet created on an application thread and
+     * released on an I/O thread comes back to the thread that creates the
+     * next one.
+     *
+     * Heaps are never deleted: when a thread exits its heap is parked in
+     * g_AbandonedHeaps and the next new thread adopts it, so a block freed
+     * late always has somewhere to go.
+     */
+    struct Heap {
+        std::array<FreeBlock*, ClassCount> Local{};
+        std::array<size_t, ClassCount> LocalCounts{};
+
+        /// Written by every thread, kept off the owner's cache line
+        alignas(64) std::array<std::atomic<FreeBlock*>, ClassCount> Remote{};
+        std::array<std::atomic<size_t>, ClassCount> RemoteCounts{};
+    };
+
+    std::mutex g_AbandonedMutex;
+    std::vector<Heap*> g_AbandonedHeaps;
+
+    /// Set once the thread's cache is gone - packets allocated during thread
+    /// or static teardown after that come from the plain heap
+    thread_local bool t_CacheDestroyed = false;
+
+    /// The current thread's heap, nullptr until it allocates (or after its cache is gone)
+    thread_local Heap* t_Heap = nullptr;
+
+    /// The heap of the current thread, adopted on first use and parked again on exit
+    struct ThreadCache {
+        Heap* Owned;
+
+        ThreadCache() {
+            std::lock_guard<std::mutex> Lock(g_AbandonedMutex);
+            if (g_AbandonedHeaps.empty()) {
+                Owned = new Heap;
+            } else {
+                Owned = g_AbandonedHeaps.back();
+                g_AbandonedHeaps.pop_back();
+            }
+
+            t_Heap = Owned;
+        }
+
+        ~ThreadCache() {
+            t_CacheDestroyed = true;
+            t_Heap = nullptr;
+
+            // Local blocks are nobody's business anymore, remote ones wait for the next owner
+            for (size_t Index = 0; Index < ClassCount; ++Index) {
+                auto Head = std::exchange(Owned->Local[Index], nullptr);
+                Owned->LocalCounts[Index] = 0;
+                while (Head) {
+                    ::operator delete(std::exchange(Head, Head->Next));
+                }
+            }
+
+            std::lock_guard<std::mutex> Lock(g_AbandonedMutex);
+            g_AbandonedHeaps.push_back(Owned);
+        }
+    };
+
+    thread_local ThreadCache t_Cache;
+
+    BlockHeader* ToHeader(void* Object) {
+        return static_cast<BlockHeader*>(Object) - 1;
+    }
+
+    /// Move everything other threads gave back into the local list, keeping at most MaxCachedPerClass
+    FreeBlock* CollectRemote(Heap& Owner, size_t Index) {
+        auto Head = Owner.Remote[Index].exchange(nullptr, std::memory_order_acquire);
+        if (!Head)
+            return nullptr;
+
+        Owner.RemoteCounts[Index].store(0, std::memory_order_relaxed);
+
+        size_t Count = 1;
+        for (auto Block = Head; Block->Next; Block = Block->Next) {
+            if (Count == PacketPool::MaxCachedPerClass) {
+                auto Excess = std::exchange(Block->Next, nullptr);
+                while (Excess) {
+                    ::operator delete(std::exchange(Excess, Excess->Next));
+                }
+                break;
+            }
+            ++Count;
+        }
+
+        Owner.LocalCounts[Index] = Count;
+        return Head;
+    }
+
+    void PushRemote(Heap& Owner, size_t Index, FreeBlock* Block) {
+        // Approximate - the owner resets it when it takes the stack - but enough to stay bounded
+        if (Owner.RemoteCounts[Index].fetch_add(1, std::memory_order_relaxed) >= PacketPool::MaxCachedPerClass) {
+            Owner.RemoteCounts[Index].fetch_sub(1, std::memory_order_relaxed);
+            ::operator delete(Block);
+            return;
+        }
+
+        auto& Head = Owner.Remote[Index];
+        Block->Next = Head.load(std::memory_order_relaxed);
+        while (!Head.compare_exchange_weak(Block->Next, Block, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+void* PacketPool::Allocate(size_t Size) {
+    if (Size > MaxPooledSize)
+        return ::operator new(Size);
+
+    const auto Index = ClassIndex(Size);
+    if (t_CacheDestroyed) {
+        auto Header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + ClassSize(Index)));
+        Header->Owner = nullptr;
+        return Header + 1;
+    }
+
+    auto& Owner = *t_Cache.Owned;
+    auto Block = Owner.Local[Index];
+    if (!Block)
+        Block = CollectRemote(Owner, Index);
+
+    if (Block) {
+        Owner.Local[Index] = Block->Next;
+        --Owner.LocalCounts[Index];
+    } else {
+        Block = static_cast<FreeBlock*>(::operator new(sizeof(BlockHeader) + ClassSize(Index)));
+    }
+
+    auto Header = reinterpret_cast<BlockHeader*>(Block);
+    Header->Owner = &Owner;
+    return Header + 1;
+}
+
+void PacketPool::Deallocate(void* Pointer, size_t Size) noexcept {
+    if (!Pointer)
+        return;
+
+    if (Size > MaxPooledSize) {
+        ::operator delete(Pointer);
+        return;
+    }
+
+    auto Header = ToHeader(Pointer);
+    auto Owner = Header->Owner;
+    auto Block = reinterpret_cast<FreeBlock*>(Header);
+    if (!Owner) {
+        ::operator delete(Block);
+        return;
+    }
+
+    // Threads that only ever free (I/O threads releasing broadcast packets) never get a heap of their own
+    const auto Index = ClassIndex(Size);
+    if (Owner != t_Heap) {
+        PushRemote(*Owner, Index, Block);
+        return;
+    }
+
+    if (Owner->LocalCounts[Index] >= MaxCachedPerClass) {
+        ::operator delete(Block);
+        return;
+    }
+
+    Block->Next = Owner->Local[Index];
+    Owner->Local[Index] = Block;
+    ++Owner->LocalCounts[Index];
+}
+
+} // namespace DrowsyNetwork
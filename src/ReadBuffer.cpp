@@ -0,0 +1,146 @@
+#include "drowsynetwork/ReadBuffer.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace DrowsyNetwork {
+
+namespace {
+    std::atomic<uint64_t> g_NextPoolId{1};
+
+    /// Set once the thread's cache is gone - blocks released during thread
+    /// or static teardown after that go straight to the shared overflow
+    thread_local bool t_CacheDestroyed = false;
+}
+
+/// Free blocks shared by all threads of one pool
+struct ReadBufferPool::Overflow {
+    std::mutex Mutex;
+    std::vector<Block> Free;            ///< Guarded by Mutex
+    std::atomic<size_t> Size{0};        ///< Free.size(), lets Take() skip the lock when empty
+    size_t MaxCached;
+
+    explicit Overflow(size_t MaxCached) : MaxCached(MaxCached) {}
+
+    /// Move up to Count blocks into To
+    void Take(std::vector<Block>& To, size_t Count) {
+        if (Size.load(std::memory_order_relaxed) == 0)
+            return;
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        for (; Count && !Free.empty(); --Count) {
+            To.push_back(std::move(Free.back()));
+            Free.pop_back();
+        }
+        Size.store(Free.size(), std::memory_order_relaxed);
+    }
+
+    /// Take over the last Count blocks of From, freeing those that don't fit
+    void Put(std::vector<Block>& From, size_t Count) {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            for (; Count && Free.size() < MaxCached; --Count) {
+                Free.push_back(std::move(From.back()));
+                From.pop_back();
+            }
+            Size.store(Free.size(), std::memory_order_relaxed);
+        }
+
+        From.resize(From.size() - Count);
+    }
+};
+
+/**
+ * @brief Free lists of one thread, one per pool it has used
+ *
+ * Only the owning thread touches them. A list holds the blocks of a pool
+ * that may be gone already - those are found through the expired weak
+ * reference and dropped the next time the thread meets a new pool. On
+ * thread exit the blocks go back to their pools' overflow.
+ */
+struct ReadBufferPool::ThreadCache {
+    struct Entry {
+        uint64_t PoolId;
+        std::weak_ptr<Overflow> Shared;
+        std::vector<Block> Free;
+    };
+
+    std::vector<Entry> Entries;
+    size_t Last = 0; ///< Entry of the last lookup, almost always the one asked for next
+
+    ~ThreadCache() {
+        t_CacheDestroyed = true;
+
+        for (auto& Entry : Entries) {
+            if (auto Shared = Entry.Shared.lock()) {
+                Shared->Put(Entry.Free, Entry.Free.size());
+            }
+        }
+    }
+};
+
+ReadBufferPool::ReadBufferPool(size_t BlockSize, size_t MaxCached) :
+    m_BlockSize(BlockSize),
+    m_Id(g_NextPoolId.fetch_add(1, std::memory_order_relaxed)),
+    m_Overflow(std::make_shared<Overflow>(MaxCached))
+{
+}
+
+std::vector<ReadBufferPool::Block>* ReadBufferPool::GetThreadFree() {
+    if (t_CacheDestroyed)
+        return nullptr;
+
+    thread_local ThreadCache t_Cache;
+    auto& Entries = t_Cache.Entries;
+    if (t_Cache.Last < Entries.size() && Entries[t_Cache.Last].PoolId == m_Id)
+        return &Entries[t_Cache.Last].Free;
+
+    for (size_t Index = 0; Index < Entries.size(); ++Index) {
+        if (Entries[Index].PoolId == m_Id) {
+            t_Cache.Last = Index;
+            return &Entries[Index].Free;
+        }
+    }
+
+    std::erase_if(Entries, [](const ThreadCache::Entry& Entry) { return Entry.Shared.expired(); });
+
+    auto& Entry = Entries.emplace_back(m_Id, m_Overflow, std::vector<Block>());
+    Entry.Free.reserve(MaxCachedPerThread + 1);
+    t_Cache.Last = Entries.size() - 1;
+    return &Entry.Free;
+}
+
+std::unique_ptr<uint8_t[]> ReadBufferPool::Acquire() {
+    if (auto* Free = GetThreadFree()) {
+        if (Free->empty())
+            m_Overflow->Take(*Free, MaxCachedPerThread / 2);
+
+        if (!Free->empty()) {
+            auto Result = std::move(Free->back());
+            Free->pop_back();
+            return Result;
+        }
+    } else {
+        std::vector<Block> Taken;
+        m_Overflow->Take(Taken, 1);
+        if (!Taken.empty())
+            return std::move(Taken.back());
+    }
+
+    return std::make_unique_for_overwrite<uint8_t[]>(m_BlockSize);
+}
+
+void ReadBufferPool::Release(std::unique_ptr<uint8_t[]>&& Released) {
+    auto* Free = GetThreadFree();
+    if (!Free) {
+        std::vector<Block> Single;
+        Single.push_back(std::move(Released));
+        m_Overflow->Put(Single, 1);
+        return;
+    }
+
+    Free->push_back(std::move(Released));
+    if (Free->size() > MaxCachedPerThread)
+        m_Overflow->Put(*Free, MaxCachedPerThread / 2);
+}
+
+} // namespace DrowsyNetwork
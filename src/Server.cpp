@@ -1,24 +1,109 @@
 #include <memory>
+#include <algorithm>
 #include "drowsynetwork/Server.hpp"
 #include "drowsynetwork/Logging.hpp"
+#include "drowsynetwork/HandlerAllocator.hpp"
+
+#include <cerrno>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#endif
 
 namespace DrowsyNetwork {
 
+namespace {
+    /// Out of descriptors or kernel memory - accepting again right away would only fail again
+    bool IsResourceExhausted(const asio::error_code& ErrorCode) {
+        return ErrorCode == asio::error::no_descriptors
+            || ErrorCode == asio::error::no_buffer_space
+            || ErrorCode == asio::error::no_memory
+            || (ErrorCode.category() == asio::error::get_system_category() && ErrorCode.value() == ENFILE);
+    }
+
+    /// Descriptor kept open so one can be freed when the process runs out
+    int OpenReserveDescriptor() {
+#ifndef _WIN32
+        return ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+#else
+        return -1;
+#endif
+    }
+}
+
 Server::Server(Executor& IOContext) :
     m_IoContext(IOContext),
-    m_Resolver(IOContext)
+    m_Resolver(IOContext),
+    m_AcceptBatchSize(DefaultAcceptBatchSize),
+    m_ConcurrentAccepts(DefaultConcurrentAccepts),
+    m_ReusePort(false),
+    m_ExecutorPool(nullptr),
+    m_Counters(std::make_shared<ServerCounters>()),
+    m_MaxConnections(0),
+    m_ReservedAccepts(0),
+    m_AcceptRate(0),
+    m_AcceptBurst(0),
+    m_AcceptTokens(0),
+    m_AcceptBackoff(StatsClock::duration::zero()),
+    m_ReserveDescriptor(OpenReserveDescriptor()),
+    m_Lifetime(std::make_shared<Lifetime>())
 {
 }
 
 Server::~Server() {
+    // Too late for derived members, but still keeps queued completions away from ours
+    Stop();
+
+#ifndef _WIN32
+    if (m_ReserveDescriptor >= 0)
+        ::close(m_ReserveDescriptor);
+#endif
+
+    m_Acceptors.clear(); // Not required since it's the deconstructor but let's show intent
+}
+
+void Server::Stop() {
+    // Waits for completions running right now, queued ones will see we're gone
+    {
+        std::unique_lock<std::mutex> Lock(m_Lifetime->Mutex);
+        if (!std::exchange(m_Lifetime->IsAlive, false))
+            return;
+
+        m_Lifetime->Finished.wait(Lock, [this] { return m_Lifetime->Running == 0; });
+    }
+
+    // Nothing else touches the acceptors or timers anymore
+    for (auto& Loop : m_AcceptLoops) {
+        Loop->RetryTimer.cancel();
+    }
+
     for (auto& Acceptor : m_Acceptors) {
         CloseAcceptor(Acceptor);
     }
+}
 
-    m_Acceptors.clear(); // Not required since it's the deconstructor but let's show intent
+bool Server::Lifetime::Enter() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (!IsAlive)
+        return false;
+
+    ++Running;
+    return true;
+}
+
+void Server::Lifetime::Leave() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (--Running == 0)
+        Finished.notify_all();
 }
 
-bool Server::Bind(std::string_view Host, std::string_view Port) {
+bool Server::Bind(std::string_view Host, std::string_view Port, const AcceptorOptions& Options) {
     asio::error_code ErrorCode;
     auto Endpoints = m_Resolver.resolve(Host, Port, ErrorCode);
     if (ErrorCode) {
@@ -30,7 +115,7 @@ bool Server::Bind(std::string_view Host, std::string_view Port) {
     for (const auto& Entry : Endpoints) {
         const auto& Endpoint = Entry.endpoint();
 
-        if (Bind(Endpoint)) {
+        if (Bind(Endpoint, Options)) {
             LOG_DEBUG("Server listening on {}:{}", Endpoint.address().to_string(), Endpoint.port());
             BoundToAtLeastOne = true;
         }
@@ -39,8 +124,8 @@ bool Server::Bind(std::string_view Host, std::string_view Port) {
     return BoundToAtLeastOne;
 }
 
-bool Server::Bind(const TcpEndpoint& Endpoint) {
-    auto Acceptor = CreateAcceptor(Endpoint.protocol());
+bool Server::Bind(const TcpEndpoint& Endpoint, const AcceptorOptions& Options) {
+    auto Acceptor = CreateAcceptor(Endpoint.protocol(), Options);
     if (!Acceptor) {
         LOG_ERROR("Failed to create acceptor.");
         return false;
@@ -53,6 +138,7 @@ bool Server::Bind(const TcpEndpoint& Endpoint) {
             ErrorCode.value(), ErrorCode.message());
         CloseAcceptor(*Acceptor);
         m_Acceptors.pop_back();
+        m_AcceptLoops.pop_back();
         return false;
     }
 
@@ -67,13 +153,22 @@ void Server::StartListening() {
         if (!Acceptor.is_open())
             continue;
 
-        Acceptor.listen(asio::socket_base::max_listen_connections, ErrorCode);
+        Acceptor.listen(m_AcceptLoops.at(Index)->Backlog, ErrorCode);
         if (ErrorCode) {
             LOG_ERROR("Failed to start listening on acceptor {}: ({}) - {}", Index, ErrorCode.value(), ErrorCode.message());
             continue;
         }
 
-        Listen(Index);
+        // Lets DrainBacklog() stop on would_block instead of blocking the thread
+        Acceptor.non_blocking(true, ErrorCode);
+        if (ErrorCode) {
+            LOG_WARN("Acceptor {} stays blocking, backlog draining disabled: ({}) - {}", Index, ErrorCode.value(), ErrorCode.message());
+        }
+
+        // Each completion re-arms one accept, so this many stay pending
+        for (size_t Pending = 0; Pending < m_ConcurrentAccepts; ++Pending) {
+            Listen(Index);
+        }
     }
 }
 
@@ -84,24 +179,294 @@ void Server::Listen(size_t Index) {
         return;
     }
 
-    auto Socket = std::make_unique<TcpSocket>(m_IoContext);
-    Acceptor->async_accept(*Socket,
-    [this, Socket = std::move(Socket), Index](asio::error_code ErrorCode) mutable {
-            Accept(Index, std::move(Socket), ErrorCode);
-        });
+    // Closed meanwhile - arming would only fail, over and over
+    if (!Acceptor->is_open())
+        return;
+
+    // Paused - ResumeAccepting() calls us again
+    if (!ReserveAccept(Index, true))
+        return;
+
+    // Take the reference before the lambda steals the pointer - argument
+    // evaluation order is unspecified
+    auto Socket = std::make_unique<TcpSocket>(NextSocketExecutor());
+    auto& Peer = *Socket;
+    Acceptor->async_accept(Peer, BindRecyclingAllocator(
+    [this, Lifetime = m_Lifetime, Socket = std::move(Socket), Index](asio::error_code ErrorCode) mutable {
+            RunIfAlive(*Lifetime, [&] { Accept(Index, std::move(Socket), ErrorCode); });
+        }));
 }
 
 void Server::Accept(size_t Index, std::unique_ptr<TcpSocket>&& Socket, asio::error_code ErrorCode) {
+    // The acceptor was closed - give the reservation back, but don't re-arm
+    if (ErrorCode == asio::error::operation_aborted) {
+        ReleaseAccept(false);
+        return;
+    }
+
     if (!ErrorCode) {
         LOG_DEBUG("Accepting socket from acceptor: {}", Index);
-        OnAccept(std::move(Socket));
+        HandOff(std::move(Socket));
+        ReleaseAccept(true);
+        DrainBacklog(Index);
     } else {
         LOG_ERROR("Accept failed for acceptor {}: ({}) - {}", Index, ErrorCode.value(), ErrorCode.message());
+        m_Counters->RecordAcceptError(ErrorCode);
+        ReleaseAccept(false);
+
+        if (IsResourceExhausted(ErrorCode))
+            HandleResourceExhaustion(Index);
     }
 
     Listen(Index);
 }
 
+void Server::DrainBacklog(size_t Index) {
+    auto Acceptor = GetAcceptor(Index);
+    if (!Acceptor || !Acceptor->is_open() || !Acceptor->non_blocking())
+        return;
+
+    // The connection that woke us up counts towards the batch
+    for (size_t Accepted = 1; m_AcceptBatchSize == 0 || Accepted < m_AcceptBatchSize; ++Accepted) {
+        // Denied - the re-arm after us pauses the acceptor
+        if (!ReserveAccept(Index, false))
+            return;
+
+        auto Socket = std::make_unique<TcpSocket>(NextSocketExecutor());
+
+        asio::error_code ErrorCode;
+        AcceptQueued(*Acceptor, *Socket, ErrorCode);
+        if (ErrorCode) {
+            ReleaseAccept(false);
+            if (ErrorCode != asio::error::would_block && ErrorCode != asio::error::try_again) {
+                LOG_ERROR("Accept failed for acceptor {}: ({}) - {}", Index, ErrorCode.value(), ErrorCode.message());
+                m_Counters->RecordAcceptError(ErrorCode);
+
+                if (IsResourceExhausted(ErrorCode))
+                    HandleResourceExhaustion(Index);
+            }
+            return;
+        }
+
+        LOG_DEBUG("Accepting queued socket from acceptor: {}", Index);
+        HandOff(std::move(Socket));
+        ReleaseAccept(true);
+    }
+}
+
+void Server::AcceptQueued(TcpAcceptor& Acceptor, TcpSocket& Socket, asio::error_code& ErrorCode) {
+#ifdef __linux__
+    for (;;) {
+        // Flags set atomically - the descriptor never leaks into a child process
+        sockaddr_storage Peer{};
+        socklen_t PeerSize = sizeof(Peer);
+        const auto Descriptor = ::accept4(Acceptor.native_handle(), reinterpret_cast<sockaddr*>(&Peer), &PeerSize,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (Descriptor < 0) {
+            // Reset while still in the backlog - not our problem, take the next one
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            ErrorCode = asio::error_code(errno, asio::error::get_system_category());
+            return;
+        }
+
+        const auto Protocol = Peer.ss_family == AF_INET6 ? asio::ip::tcp::v6() : asio::ip::tcp::v4();
+        Socket.assign(Protocol, Descriptor, ErrorCode);
+        if (ErrorCode)
+            ::close(Descriptor);
+        return;
+    }
+#else
+    Acceptor.accept(Socket, ErrorCode);
+#endif
+}
+
+bool Server::ReserveAccept(size_t Index, bool PauseIfDenied) {
+    std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+    const auto Now = StatsClock::now();
+
+    if (m_AcceptRate > 0) {
+        const auto Elapsed = std::chrono::duration<double>(Now - m_AcceptTokensUpdated).count();
+        m_AcceptTokens = std::min(m_AcceptBurst, m_AcceptTokens + Elapsed * m_AcceptRate);
+        m_AcceptTokensUpdated = Now;
+    }
+
+    const char* Reason = nullptr;
+    StatsClock::duration RetryAfter{};
+    if (Now < m_AcceptBackoffUntil) {
+        Reason = "out of descriptors";
+        RetryAfter = m_AcceptBackoffUntil - Now;
+    } else if (m_MaxConnections) {
+        const auto Open = m_Counters->Get(ServerCounters::Connections);
+        if (Open + m_ReservedAccepts >= m_MaxConnections) {
+            Reason = "connection cap reached";
+            RetryAfter = AcceptRetryInterval;
+        }
+    }
+
+    if (!Reason && m_AcceptRate > 0 && m_AcceptTokens < 1) {
+        Reason = "accept rate limit";
+        RetryAfter = std::chrono::duration_cast<StatsClock::duration>(std::chrono::duration<double>((1 - m_AcceptTokens) / m_AcceptRate));
+    }
+
+    auto& Loop = *m_AcceptLoops.at(Index);
+    if (!Reason) {
+        if (m_AcceptRate > 0)
+            m_AcceptTokens -= 1;
+
+        ++m_ReservedAccepts;
+        if (std::exchange(Loop.IsPaused, false))
+            LOG_DEBUG("Acceptor {} resumed", Index);
+        return true;
+    }
+
+    if (!PauseIfDenied)
+        return false;
+
+    if (!std::exchange(Loop.IsPaused, true))
+        LOG_DEBUG("Acceptor {} paused: {}", Index, Reason);
+
+    ++Loop.PausedAccepts;
+    if (!Loop.IsRetryPending) {
+        Loop.IsRetryPending = true;
+        Loop.RetryTimer.expires_after(RetryAfter);
+        Loop.RetryTimer.async_wait([this, Lifetime = m_Lifetime, Index](asio::error_code ErrorCode) {
+            // Cancelled by Stop(), or queued just before it ran
+            if (ErrorCode == asio::error::operation_aborted)
+                return;
+
+            RunIfAlive(*Lifetime, [&] { ResumeAccepting(Index); });
+        });
+    }
+
+    return false;
+}
+
+void Server::ReleaseAccept(bool Accepted) {
+    std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+    --m_ReservedAccepts;
+
+    if (Accepted) {
+        m_AcceptBackoff = StatsClock::duration::zero();
+    } else if (m_AcceptRate > 0) {
+        // Nothing came of it, the token goes back
+        m_AcceptTokens = std::min(m_AcceptBurst, m_AcceptTokens + 1);
+    }
+}
+
+void Server::ResumeAccepting(size_t Index) {
+    size_t Count = 0;
+    {
+        std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+        auto& Loop = *m_AcceptLoops.at(Index);
+        Loop.IsRetryPending = false;
+        Count = std::exchange(Loop.PausedAccepts, 0);
+    }
+
+    // Each one pauses again if it's still denied
+    for (size_t Pending = 0; Pending < Count; ++Pending) {
+        Listen(Index);
+    }
+}
+
+void Server::HandleResourceExhaustion(size_t Index) {
+    std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+
+#ifndef _WIN32
+    auto Acceptor = GetAcceptor(Index);
+    if (Acceptor && Acceptor->non_blocking() && m_ReserveDescriptor >= 0) {
+        ::close(m_ReserveDescriptor);
+
+        TcpSocket Shed(m_IoContext);
+        asio::error_code ErrorCode;
+        AcceptQueued(*Acceptor, Shed, ErrorCode);
+        if (!ErrorCode) {
+            LOG_WARN("Acceptor {} closed a connection it had no descriptors for", Index);
+            Shed.close(ErrorCode);
+        }
+
+        m_ReserveDescriptor = OpenReserveDescriptor();
+    }
+#endif
+
+    m_AcceptBackoff = std::clamp<StatsClock::duration>(m_AcceptBackoff * 2, MinAcceptBackoff, MaxAcceptBackoff);
+    m_AcceptBackoffUntil = StatsClock::now() + m_AcceptBackoff;
+    LOG_WARN("Acceptor {} out of descriptors, pausing accepts for {}ms", Index,
+        std::chrono::duration_cast<std::chrono::milliseconds>(m_AcceptBackoff).count());
+}
+
+void Server::HandOff(std::unique_ptr<TcpSocket>&& Socket) {
+    m_Counters->Add(ServerCounters::Accepted, 1);
+
+    // Admitted until the socket made from it disconnects, see Socket::CountClose()
+    m_Counters->Add(ServerCounters::Connections, 1);
+    OnAccept(std::move(Socket));
+
+    // Turned away without being taken - there's no socket to release the slot later
+    if (Socket)
+        m_Counters->Subtract(ServerCounters::Connections, 1);
+}
+
+void Server::SetAcceptBatchSize(size_t BatchSize) {
+    m_AcceptBatchSize = BatchSize;
+}
+
+void Server::SetConcurrentAccepts(size_t Count) {
+    m_ConcurrentAccepts = std::max<size_t>(Count, 1);
+}
+
+void Server::SetAcceptRateLimit(double ConnectionsPerSecond, size_t Burst) {
+    std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+    m_AcceptRate = std::max(ConnectionsPerSecond, 0.0);
+    m_AcceptBurst = Burst ? static_cast<double>(Burst) : std::max(m_AcceptRate, 1.0);
+    m_AcceptTokens = m_AcceptBurst;
+    m_AcceptTokensUpdated = StatsClock::now();
+}
+
+void Server::SetMaxConnections(size_t MaxConnections) {
+    std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+    m_MaxConnections = MaxConnections;
+}
+
+bool Server::IsAcceptPaused() const {
+    std::lock_guard<std::mutex> Lock(m_AdmissionMutex);
+    return std::ranges::any_of(m_AcceptLoops, [](const auto& Loop) { return Loop->IsPaused; });
+}
+
+void Server::SetReusePort(bool ReusePort) {
+#ifndef SO_REUSEPORT
+    if (ReusePort) {
+        LOG_WARN("SO_REUSEPORT is not supported on this platform");
+    }
+#endif
+    m_ReusePort = ReusePort;
+}
+
+void Server::SetExecutorPool(ExecutorPool* Pool) {
+    m_ExecutorPool = Pool;
+}
+
+Executor& Server::GetSocketExecutor(TcpSocket& Socket) {
+    return static_cast<Executor&>(Socket.get_executor().context());
+}
+
+ServerStats Server::GetStats() const {
+    return m_Counters->Snapshot();
+}
+
+HistogramSnapshot Server::GetLatency(LatencyMetric Metric) const {
+    return m_Counters->GetLatency(Metric);
+}
+
+void Server::SetLatencyTracking(bool Enabled) {
+    m_Counters->SetTrackingLatency(Enabled);
+}
+
+Executor& Server::NextSocketExecutor() {
+    return m_ExecutorPool ? m_ExecutorPool->GetNextExecutor() : m_IoContext;
+}
+
 TcpAcceptor* Server::GetAcceptor(size_t Index) {
     if (Index >= m_Acceptors.size())
         return nullptr;
@@ -109,26 +474,85 @@ TcpAcceptor* Server::GetAcceptor(size_t Index) {
     return &m_Acceptors.at(Index);
 }
 
-TcpAcceptor* Server::CreateAcceptor(const asio::ip::tcp& Protocol) {
+TcpAcceptor* Server::CreateAcceptor(const asio::ip::tcp& Protocol, const AcceptorOptions& Options) {
     TcpAcceptor Acceptor(m_IoContext);
 
     asio::error_code ErrorCode;
     Acceptor.open(Protocol, ErrorCode);
+    if (ErrorCode) {
+        LOG_ERROR("Error opening acceptor type {}: ({}) - {}", Protocol == asio::ip::tcp::v4() ? "IPv4" : "IPv6", ErrorCode.value(), ErrorCode.message());
+        return nullptr;
+    }
 
     Acceptor.set_option(asio::socket_base::reuse_address(true));
 
+#ifdef SO_REUSEPORT
+    if (m_ReusePort || Options.ReusePort) {
+        using ReusePortOption = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+        Acceptor.set_option(ReusePortOption(true), ErrorCode);
+        if (ErrorCode) {
+            LOG_WARN("Failed to enable SO_REUSEPORT: ({}) - {}", ErrorCode.value(), ErrorCode.message());
+        }
+    }
+#endif
+
     if (Protocol == asio::ip::tcp::v6()) {
         Acceptor.set_option(asio::ip::v6_only(true));
     }
 
-    if (ErrorCode) {
-        LOG_ERROR("Error opening acceptor type {}: ({}) - {}", Protocol == asio::ip::tcp::v4() ? "IPv4" : "IPv6", ErrorCode.value(), ErrorCode.message());
-        return nullptr;
-    }
+    ApplyAcceptorOptions(Acceptor, Options);
 
+    m_AcceptLoops.push_back(std::make_unique<AcceptLoop>(m_IoContext, Options.Backlog));
     return &m_Acceptors.emplace_back(std::move(Acceptor));
 }
 
+void Server::ApplyAcceptorOptions(TcpAcceptor& Acceptor, const AcceptorOptions& Options) {
+    asio::error_code ErrorCode;
+
+#ifndef SO_REUSEPORT
+    if (Options.ReusePort) {
+        LOG_WARN("SO_REUSEPORT is not supported on this platform");
+    }
+#endif
+
+    if (Options.DeferAccept.count() > 0) {
+#ifdef TCP_DEFER_ACCEPT
+        using DeferAcceptOption = asio::detail::socket_option::integer<IPPROTO_TCP, TCP_DEFER_ACCEPT>;
+        Acceptor.set_option(DeferAcceptOption(static_cast<int>(Options.DeferAccept.count())), ErrorCode);
+        if (ErrorCode) {
+            LOG_WARN("Failed to enable TCP_DEFER_ACCEPT: ({}) - {}", ErrorCode.value(), ErrorCode.message());
+        }
+#else
+        LOG_WARN("TCP_DEFER_ACCEPT is not supported on this platform");
+#endif
+    }
+
+    if (Options.FastOpenQueueLength > 0) {
+#ifdef TCP_FASTOPEN
+        // Linux takes the queue length, other platforms just a switch - a positive value works for both
+        using FastOpenOption = asio::detail::socket_option::integer<IPPROTO_TCP, TCP_FASTOPEN>;
+        Acceptor.set_option(FastOpenOption(Options.FastOpenQueueLength), ErrorCode);
+        if (ErrorCode) {
+            LOG_WARN("Failed to enable TCP_FASTOPEN: ({}) - {}", ErrorCode.value(), ErrorCode.message());
+        }
+#else
+        LOG_WARN("TCP_FASTOPEN is not supported on this platform");
+#endif
+    }
+
+    if (Options.IncomingCpu >= 0) {
+#ifdef SO_INCOMING_CPU
+        using IncomingCpuOption = asio::detail::socket_option::integer<SOL_SOCKET, SO_INCOMING_CPU>;
+        Acceptor.set_option(IncomingCpuOption(Options.IncomingCpu), ErrorCode);
+        if (ErrorCode) {
+            LOG_WARN("Failed to set SO_INCOMING_CPU: ({}) - {}", ErrorCode.value(), ErrorCode.message());
+        }
+#else
+        LOG_WARN("SO_INCOMING_CPU is not supported on this platform");
+#endif
+    }
+}
+
 void Server::CloseAcceptor(TcpAcceptor& Acceptor) {
     if (!Acceptor.is_open())
         return;
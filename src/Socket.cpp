@@ -1,21 +1,113 @@
 #include "drowsynetwork/Socket.hpp"
+#include "drowsynetwork/ConnectionRegistry.hpp"
+#include <algorithm>
+#include <limits>
+#include <ranges>
+#include <utility>
 
 namespace DrowsyNetwork {
 
-Socket::Socket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket) :
+namespace {
+    /// Ids each thread reserves from the shared counter at once
+    constexpr uint64_t SocketIdBlockSize = 1024;
+
+    uint64_t NextSocketId() {
+        // Accept storms on many threads would otherwise all hammer one cache line
+        static std::atomic<uint64_t> s_NextBlock(1);
+        thread_local uint64_t t_NextId = 0;
+        thread_local uint64_t t_BlockEnd = 0;
+
+        if (t_NextId == t_BlockEnd) {
+            t_NextId = s_NextBlock.fetch_add(SocketIdBlockSize, std::memory_order_relaxed);
+            t_BlockEnd = t_NextId + SocketIdBlockSize;
+        }
+
+        return t_NextId++;
+    }
+}
+
+Socket::Socket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket, size_t ReadBufferSize) :
     m_Strand(IOContext.get_executor()),
     m_Socket(std::move(Socket)),
+    m_Id(NextSocketId()),
+    m_IsActive(false),
+    m_Operations(std::make_shared<OperationState>(ReadBufferSize)),
+    m_WriteBatch(m_Operations->WriteBatch),
+    m_MaxWriteBatchPackets(MaxWriteBuffers),
+    m_MaxWriteBatchBytes(DefaultWriteBatchBytes),
+    m_WriteBatchBytes(0),
+    m_RealtimeWeight(DefaultRealtimeWeight),
+    m_BulkWeight(DefaultBulkWeight),
+    m_PendingWriteBytes(0),
+    m_PendingWritePackets(0),
+    m_LowWatermarkBytes(0),
+    m_HighWatermarkBytes(0),
+    m_LowWatermarkPackets(0),
+    m_HighWatermarkPackets(0),
+    m_MaxPendingBytes(0),
+    m_MaxPendingPackets(0),
+    m_OverflowPolicy(WriteOverflowPolicy::Disconnect),
+    m_IsWriteBlocked(false),
+    m_TrackLatency(false),
+    m_IsCountedOpen(false),
+    m_ReadBuffer(m_Operations->Read),
     m_IsWriting(false),
-    m_IsActive(false) {
-    static std::atomic<uint64_t> s_NextId(1);
-    m_Id = s_NextId.fetch_add(1);
-
+    m_Registry(nullptr) {
     LOG_DEBUG("Socket {} created", m_Id);
 }
 
+Socket::Socket(Executor& IOContext, std::unique_ptr<TcpSocket>&& Socket, std::shared_ptr<ReadBufferPool> Pool) :
+    m_Strand(IOContext.get_executor()),
+    m_Socket(std::move(Socket)),
+    m_Id(NextSocketId()),
+    m_IsActive(false),
+    m_Operations(std::make_shared<OperationState>(std::move(Pool))),
+    m_WriteBatch(m_Operations->WriteBatch),
+    m_MaxWriteBatchPackets(MaxWriteBuffers),
+    m_MaxWriteBatchBytes(DefaultWriteBatchBytes),
+    m_WriteBatchBytes(0),
+    m_RealtimeWeight(DefaultRealtimeWeight),
+    m_BulkWeight(DefaultBulkWeight),
+    m_PendingWriteBytes(0),
+    m_PendingWritePackets(0),
+    m_LowWatermarkBytes(0),
+    m_HighWatermarkBytes(0),
+    m_LowWatermarkPackets(0),
+    m_HighWatermarkPackets(0),
+    m_MaxPendingBytes(0),
+    m_MaxPendingPackets(0),
+    m_OverflowPolicy(WriteOverflowPolicy::Disconnect),
+    m_IsWriteBlocked(false),
+    m_TrackLatency(false),
+    m_IsCountedOpen(false),
+    m_ReadBuffer(m_Operations->Read),
+    m_IsWriting(false),
+    m_Registry(nullptr) {
+    // Pooled reads are drained with non-blocking read_some after a readiness wait
+    asio::error_code ErrorCode;
+    m_Socket->non_blocking(true, ErrorCode);
+
+    LOG_DEBUG("Socket {} created (pooled read buffer)", m_Id);
+}
+
 Socket::~Socket() {
-    // asio sockets will clean after themselves when they go out of scope but let's show intent
-    Socket::HandleDisconnect(); // Make sure we properly clean the resources
+    // asio sockets will clean after themselves when they go out of scope but let's show intent.
+    // Don't go through HandleDisconnect() - the derived part is already gone, so OnDisconnect()
+    // can't be called anymore
+    if (m_Socket && m_Socket->is_open()) {
+        asio::error_code ErrorCode;
+        m_Socket->shutdown(asio::socket_base::shutdown_both, ErrorCode);
+        m_Socket->close(ErrorCode);
+    }
+
+    if (m_ServerCounters) {
+        // Writes still pending (aborted or never started) die with us
+        m_ServerCounters->Subtract(ServerCounters::PendingWriteBytes, GetPendingWriteBytes());
+        m_ServerCounters->Subtract(ServerCounters::PendingWritePackets, GetPendingWritePackets());
+    }
+
+    // Never disconnected, e.g. because its context stopped running
+    CountClose();
 
     LOG_DEBUG("Socket {} destroyed", m_Id);
 }
@@ -24,6 +116,10 @@ TcpSocket* Socket::GetSocket() const {
     return m_Socket.get();
 }
 
+Executor& Socket::GetExecutor() const {
+    return static_cast<Executor&>(asio::query(m_Strand, asio::execution::context));
+}
+
 void Socket::Setup() {
     asio::post(m_Strand, [self = weak_from_this()]() {
         if (auto Socket = self.lock()) {
@@ -33,24 +129,261 @@ void Socket::Setup() {
     });
 }
 
+void Socket::Setup(std::shared_ptr<ServerCounters> Counters) {
+    if (Counters && !m_ServerCounters) {
+        m_ServerCounters = std::move(Counters);
+        m_TrackLatency = m_ServerCounters->IsTrackingLatency();
+        m_IsCountedOpen = true;
+        m_ServerCounters->Add(ServerCounters::SocketsOpened, 1);
+
+        // Sent before we got here - released into the server's gauges later on
+        m_ServerCounters->Add(ServerCounters::PendingWriteBytes, GetPendingWriteBytes());
+        m_ServerCounters->Add(ServerCounters::PendingWritePackets, GetPendingWritePackets());
+    }
+
+    Setup();
+}
+
+void Socket::Send(IPacketBasePtr Packet, SendPriority Priority) {
+    // Counted right away, so packets still on their way to the strand show up in the backlog
+    m_PendingWriteBytes.fetch_add(Packet->size(), std::memory_order_relaxed);
+    m_PendingWritePackets.fetch_add(1, std::memory_order_relaxed);
+    if (m_ServerCounters) {
+        m_ServerCounters->Add(ServerCounters::PendingWriteBytes, Packet->size());
+        m_ServerCounters->Add(ServerCounters::PendingWritePackets, 1);
+    }
+
+    if (m_Strand.running_in_this_thread()) {
+        // Already on the correct thread - queue directly, there's no dispatch to time
+        EnqueueSend(std::move(Packet), Priority);
+        return;
+    }
+
+    const auto SentAt = m_TrackLatency ? StatsClock::now() : StatsClock::time_point{};
+
+    // Runs inline if the strand is idle and we're on its context, posts otherwise
+    asio::dispatch(m_Strand, BindRecyclingAllocator([self = weak_from_this(), Packet = std::move(Packet), Priority, SentAt]() mutable {
+        if (auto socket = self.lock()) {
+            socket->EnqueueSend(std::move(Packet), Priority, SentAt);
+        } else {
+            LOG_ERROR("Invalid socket at send");
+        }
+    }));
+}
+
+bool Socket::TrySend(IPacketBasePtr Packet, SendPriority Priority) {
+    if (!IsActive())
+        return false;
+
+    const auto Bytes = GetPendingWriteBytes() + Packet->size();
+    const auto Packets = GetPendingWritePackets() + 1;
+
+    const auto ByteLimit = m_HighWatermarkBytes ? m_HighWatermarkBytes : m_MaxPendingBytes;
+    const auto PacketLimit = m_HighWatermarkPackets ? m_HighWatermarkPackets : m_MaxPendingPackets;
+    if ((ByteLimit && Bytes > ByteLimit) || (PacketLimit && Packets > PacketLimit))
+        return false;
+
+    Send(std::move(Packet), Priority);
+    return true;
+}
+
+void Socket::EnqueueSend(IPacketBasePtr Packet, SendPriority Priority, StatsClock::time_point SentAt) {
+    if (!IsActive()) {
+        ReleasePendingWrites(1, Packet->size());
+        return;
+    }
+
+    // How long the packet waited for the strand - on-strand and direct callers didn't wait, they count from here
+    if (m_TrackLatency) {
+        const auto Now = StatsClock::now();
+        if (SentAt == StatsClock::time_point{}) {
+            SentAt = Now;
+        } else {
+            m_ServerCounters->RecordLatency(LatencyMetric::SendDispatch, Now - SentAt);
+        }
+    }
+
+    m_WriteQueues[static_cast<size_t>(Priority)].PushBack({ std::move(Packet), SentAt });
+
+    if (!m_IsWriteBlocked && IsAboveHighWatermark()) {
+        m_IsWriteBlocked = true;
+        LOG_DEBUG("Socket {} write queue blocked ({} bytes, {} packets pending)", m_Id, GetPendingWriteBytes(), GetPendingWritePackets());
+        OnWriteBlocked();
+    }
+
+    // May disconnect us, or drop everything queued (even this packet)
+    EnforceWriteHardLimit();
+    if (!IsActive() || !HasQueuedWrites())
+        return;
+
+    // Start writing if not already in progress
+    if (!m_IsWriting) {
+        m_IsWriting = true;
+        HandleWrite();
+    }
+}
+
 void Socket::HandleWrite() {
-    if (!IsActive() || m_WriteQueue.empty())
+    if (!IsActive() || !HasQueuedWrites())
         return;
 
-    auto& Instance = m_WriteQueue.front();
+    m_WriteBatch.clear();
+    m_WriteBatchSentAt.clear();
+    m_Operations->WriteBuffers.clear();
+    PrepareWriteBatch();
+    m_WriteStartTime = StatsClock::now();
+    RecordBatchLatency(LatencyMetric::SendQueue, m_WriteStartTime);
 
-    asio::async_write(*m_Socket, asio::buffer(Instance->data(), Instance->size()),
-        asio::bind_executor(m_Strand, [self = weak_from_this()](asio::error_code ErrorCode, std::size_t BytesTransferred) {
+    // Pass a view - the handler keeps the buffer sequence alive even if we die first
+    auto& Operations = *m_Operations;
+    asio::async_write(*m_Socket, std::span<const ConstBuffer>(Operations.WriteBuffers), BindHandlerMemory(Operations.WriteMemory,
+        asio::bind_executor(m_Strand, [self = weak_from_this(), State = m_Operations](asio::error_code ErrorCode, std::size_t BytesTransferred) {
             if (auto Socket = self.lock()) {
                 Socket->FinishWrite(ErrorCode, BytesTransferred);
             } else {
                 // Handle invalid socket
                 LOG_ERROR("Invalid socket at handle write");
             }
-    }));
+    })));
+}
+
+void Socket::PrepareWriteBatch() {
+    CollectWriteBatch(m_MaxWriteBatchPackets);
+
+    for (const auto& Packet : m_WriteBatch) {
+        m_Operations->WriteBuffers.emplace_back(Packet->data(), Packet->size());
+    }
+}
+
+size_t Socket::CollectWriteBatch(size_t MaxPackets) {
+    // Control packets are small and urgent - they get everything they need
+    auto BatchBytes = CollectLane(SendPriority::Control, MaxPackets, m_MaxWriteBatchBytes, true);
+
+    const auto RemainingBytes = [&] { return m_MaxWriteBatchBytes - std::min(BatchBytes, m_MaxWriteBatchBytes); };
+    const auto RealtimeShare = RemainingBytes() / (m_RealtimeWeight + m_BulkWeight) * m_RealtimeWeight;
+
+    // Each lane gets its share, then Realtime may use what Bulk left over
+    BatchBytes += CollectLane(SendPriority::Realtime, MaxPackets, RealtimeShare, true);
+    BatchBytes += CollectLane(SendPriority::Bulk, MaxPackets, RemainingBytes(), true);
+    BatchBytes += CollectLane(SendPriority::Realtime, MaxPackets, RemainingBytes(), false);
+
+    m_WriteBatchBytes = BatchBytes;
+    return m_WriteBatch.size();
+}
+
+size_t Socket::CollectLane(SendPriority Priority, size_t MaxPackets, size_t MaxBytes, bool TakeFirst) {
+    auto& Queue = m_WriteQueues[static_cast<size_t>(Priority)];
+
+    size_t LaneBytes = 0;
+    while (!Queue.Empty() && m_WriteBatch.size() < MaxPackets) {
+        // The first packet may ignore the budget, so big packets can't stall their lane
+        const auto PacketSize = Queue.Front().Packet->size();
+        if (!(TakeFirst && LaneBytes == 0) && LaneBytes + PacketSize > MaxBytes)
+            break;
+
+        LaneBytes += PacketSize;
+        m_WriteBatch.push_back(std::move(Queue.Front().Packet));
+        if (m_TrackLatency)
+            m_WriteBatchSentAt.push_back(Queue.Front().SentAt);
+        Queue.PopFront();
+    }
+
+    return LaneBytes;
+}
+
+bool Socket::HasQueuedWrites() const {
+    return std::ranges::any_of(m_WriteQueues, [](const auto& Queue) { return !Queue.Empty(); });
+}
+
+size_t Socket::GetQueuedWriteCount() const {
+    size_t Count = 0;
+    for (const auto& Queue : m_WriteQueues) {
+        Count += Queue.Size();
+    }
+
+    return Count;
+}
+
+void Socket::ReleasePendingWrites(size_t Packets, size_t Bytes) {
+    m_PendingWriteBytes.fetch_sub(Bytes, std::memory_order_relaxed);
+    m_PendingWritePackets.fetch_sub(Packets, std::memory_order_relaxed);
+    if (m_ServerCounters) {
+        m_ServerCounters->Subtract(ServerCounters::PendingWriteBytes, Bytes);
+        m_ServerCounters->Subtract(ServerCounters::PendingWritePackets, Packets);
+    }
+
+    if (m_IsWriteBlocked && GetPendingWriteBytes() <= m_LowWatermarkBytes &&
+        GetPendingWritePackets() <= m_LowWatermarkPackets) {
+        m_IsWriteBlocked = false;
+        LOG_DEBUG("Socket {} write queue drained", m_Id);
+
+        // Nobody needs to resume producing for a closed socket
+        if (IsActive())
+            OnWriteDrained();
+    }
+}
+
+bool Socket::IsAboveHighWatermark() const {
+    return (m_HighWatermarkBytes && GetPendingWriteBytes() > m_HighWatermarkBytes) ||
+           (m_HighWatermarkPackets && GetPendingWritePackets() > m_HighWatermarkPackets);
+}
+
+void Socket::EnforceWriteHardLimit() {
+    const auto IsOverLimit = [this] {
+        return (m_MaxPendingBytes && GetPendingWriteBytes() > m_MaxPendingBytes) ||
+               (m_MaxPendingPackets && GetPendingWritePackets() > m_MaxPendingPackets);
+    };
+
+    if (!IsOverLimit())
+        return;
+
+    if (m_OverflowPolicy == WriteOverflowPolicy::Disconnect) {
+        LOG_WARN("Socket {} write queue over limit ({} bytes, {} packets pending), disconnecting",
+            m_Id, GetPendingWriteBytes(), GetPendingWritePackets());
+        Disconnect();
+        return;
+    }
+
+    // Only whole queued packets are dropped - the write in flight stays intact,
+    // so framing is never broken. Bulk goes first, Control last.
+    size_t DroppedPackets = 0;
+    size_t DroppedBytes = 0;
+    for (auto& Queue : m_WriteQueues | std::views::reverse) {
+        while (!Queue.Empty() && IsOverLimit()) {
+            const auto PacketSize = Queue.Front().Packet->size();
+            Queue.PopFront();
+            ReleasePendingWrites(1, PacketSize);
+
+            ++DroppedPackets;
+            DroppedBytes += PacketSize;
+        }
+    }
+
+    LOG_WARN("Socket {} write queue over limit, dropped {} oldest packets ({} bytes)", m_Id, DroppedPackets, DroppedBytes);
+}
+
+void Socket::RecordBatchLatency(LatencyMetric Metric, StatsClock::time_point Now) {
+    if (!m_TrackLatency)
+        return;
+
+    for (const auto SentAt : m_WriteBatchSentAt) {
+        m_ServerCounters->RecordLatency(Metric, Now - SentAt);
+    }
 }
 
 void Socket::FinishWrite(asio::error_code ErrorCode, std::size_t BytesTransferred) {
+    const auto Now = StatsClock::now();
+    if (!ErrorCode)
+        RecordBatchLatency(LatencyMetric::SendToWire, Now);
+
+    // Whatever happened, the batch is no longer referenced by the write
+    const auto BatchSize = m_WriteBatch.size();
+    m_WriteBatch.clear();
+    m_WriteBatchSentAt.clear();
+    m_Operations->WriteBuffers.clear();
+    ReleasePendingWrites(BatchSize, m_WriteBatchBytes);
+    m_WriteBatchBytes = 0;
+
     if (!IsActive())
         return;
 
@@ -62,24 +395,73 @@ void Socket::FinishWrite(asio::error_code ErrorCode, std::size_t BytesTransferre
         return;
     }
 
-    auto& Instance = m_WriteQueue.front();
-    LOG_DEBUG("Socket {} sent {} bytes, remaining {} ref count", m_Id, Instance->size(), Instance.use_count());
-    m_WriteQueue.pop_front();
-    if (!m_WriteQueue.empty())
+    const auto Duration = std::chrono::duration_cast<std::chrono::nanoseconds>(Now - m_WriteStartTime);
+    m_Counters.RecordWrite(BytesTransferred, BatchSize, Duration.count());
+    if (m_ServerCounters) {
+        m_ServerCounters->Add(ServerCounters::BytesSent, BytesTransferred);
+        m_ServerCounters->Add(ServerCounters::PacketsSent, BatchSize);
+        m_ServerCounters->Add(ServerCounters::Writes, 1);
+    }
+
+    LOG_DEBUG("Socket {} sent {} bytes in {} packets, {} still queued", m_Id, BytesTransferred, BatchSize, GetQueuedWriteCount());
+    if (HasQueuedWrites())
         HandleWrite();
     else
         m_IsWriting = false;
 }
 
+void Socket::SetWriteBatchLimits(size_t MaxPackets, size_t MaxBytes) {
+    m_MaxWriteBatchPackets = std::clamp<size_t>(MaxPackets, 1, MaxWriteBuffers);
+    m_MaxWriteBatchBytes = std::max<size_t>(MaxBytes, 1);
+}
+
+void Socket::SetPriorityWeights(size_t RealtimeWeight, size_t BulkWeight) {
+    m_RealtimeWeight = std::max<size_t>(RealtimeWeight, 1);
+    m_BulkWeight = std::max<size_t>(BulkWeight, 1);
+}
+
+void Socket::SetWriteWatermarks(size_t LowBytes, size_t HighBytes, size_t LowPackets, size_t HighPackets) {
+    m_HighWatermarkBytes = HighBytes;
+    m_LowWatermarkBytes = HighBytes ? std::min(LowBytes, HighBytes) : std::numeric_limits<size_t>::max();
+    m_HighWatermarkPackets = HighPackets;
+    m_LowWatermarkPackets = HighPackets ? std::min(LowPackets, HighPackets) : std::numeric_limits<size_t>::max();
+}
+
+void Socket::SetWriteHardLimit(size_t MaxBytes, size_t MaxPackets, WriteOverflowPolicy Policy) {
+    m_MaxPendingBytes = MaxBytes;
+    m_MaxPendingPackets = MaxPackets;
+    m_OverflowPolicy = Policy;
+}
+
 void Socket::HandleRead() {
-    asio::async_read(*m_Socket, m_ReadBuffer, asio::transfer_at_least(1),
+    // Idle pooled sockets hold no buffer while waiting for data
+    if (m_ReadBuffer.Release()) {
+        m_Socket->async_wait(TcpSocket::wait_read, BindHandlerMemory(m_Operations->ReadMemory,
+            asio::bind_executor(m_Strand,
+            [self = weak_from_this(), State = m_Operations](asio::error_code ErrorCode) {
+                if (auto socket = self.lock()) {
+                    socket->FinishWait(ErrorCode);
+                }
+            }
+        )));
+        return;
+    }
+
+    const auto Tail = m_ReadBuffer.Prepare();
+    if (Tail.size() == 0) {
+        LOG_ERROR("Socket {} read buffer is full ({} bytes unread)", m_Id, m_ReadBuffer.Size());
+        Disconnect();
+        return;
+    }
+
+    m_Socket->async_read_some(Tail, BindHandlerMemory(m_Operations->ReadMemory,
         asio::bind_executor(m_Strand,
-        [self = weak_from_this()](asio::error_code ErrorCode, std::size_t BytesTransferred) {
+        [self = weak_from_this(), State = m_Operations](asio::error_code ErrorCode, std::size_t BytesTransferred) {
             if (auto socket = self.lock()) {
                 socket->FinishRead(ErrorCode, BytesTransferred);
             }
         }
-    ));
+    )));
 }
 
 void Socket::FinishRead(asio::error_code ErrorCode, std::size_t BytesTransferred) {
@@ -96,14 +478,52 @@ void Socket::FinishRead(asio::error_code ErrorCode, std::size_t BytesTransferred
         return;
     }
 
-    const auto Data = m_ReadBuffer.data();
+    m_Counters.RecordRead(BytesTransferred);
+    if (m_ServerCounters) {
+        m_ServerCounters->Add(ServerCounters::BytesReceived, BytesTransferred);
+        m_ServerCounters->Add(ServerCounters::Reads, 1);
+    }
+
+    const auto ReadAt = m_TrackLatency ? StatsClock::now() : StatsClock::time_point{};
+
+    m_ReadBuffer.Commit(BytesTransferred);
+    m_ReadBuffer.Consume(ProcessRead(m_ReadBuffer.Data(), m_ReadBuffer.Size()));
 
-    OnRead(static_cast<const uint8_t*>(Data.data()), Data.size());
+    if (m_TrackLatency) {
+        m_ServerCounters->RecordLatency(LatencyMetric::ReadHandler, StatsClock::now() - ReadAt);
+    }
+
+    // The handler may have decided to disconnect us
+    if (!IsActive())
+        return;
 
-    m_ReadBuffer.consume(BytesTransferred);
     HandleRead();
 }
 
+void Socket::FinishWait(asio::error_code ErrorCode) {
+    if (!IsActive())
+        return;
+
+    if (ErrorCode) {
+        FinishRead(ErrorCode, 0);
+        return;
+    }
+
+    const auto BytesTransferred = m_Socket->read_some(m_ReadBuffer.Prepare(), ErrorCode);
+    if (ErrorCode == asio::error::would_block || ErrorCode == asio::error::try_again) {
+        // Spurious wakeup - nothing to read after all
+        HandleRead();
+        return;
+    }
+
+    FinishRead(ErrorCode, BytesTransferred);
+}
+
+size_t Socket::ProcessRead(const uint8_t* Data, size_t Size) {
+    OnRead(Data, Size);
+    return Size;
+}
+
 void Socket::SetActive(bool ActiveStatus) {
     m_IsActive = ActiveStatus;
 }
@@ -131,14 +551,47 @@ void Socket::HandleDisconnect() {
     }
 
     SetActive(false);
-    m_WriteQueue.clear(); // Clear message queue
+
+    // Clear message queue - the write in flight (if any) is released when it completes
+    size_t DroppedPackets = 0;
+    size_t DroppedBytes = 0;
+    for (auto& Queue : m_WriteQueues) {
+        while (!Queue.Empty()) {
+            DroppedBytes += Queue.Front().Packet->size();
+            Queue.PopFront();
+            ++DroppedPackets;
+        }
+    }
+    ReleasePendingWrites(DroppedPackets, DroppedBytes);
     m_IsWriting = false;
 
     LOG_DEBUG("Socket {} disconnected", m_Id);
+    CountClose();
+
+    if (auto Registry = m_Registry.load()) {
+        Registry->Remove(m_Id);
+    }
 
     OnDisconnect();
 }
 
+void Socket::CountClose() {
+    if (!std::exchange(m_IsCountedOpen, false))
+        return;
+
+    m_ServerCounters->Add(ServerCounters::SocketsClosed, 1);
+
+    // Frees our slot under Server::SetMaxConnections()
+    m_ServerCounters->Subtract(ServerCounters::Connections, 1);
+}
+
+SocketStats Socket::GetStats() const {
+    auto Stats = m_Counters.Snapshot();
+    Stats.PendingWriteBytes = GetPendingWriteBytes();
+    Stats.PendingWritePackets = GetPendingWritePackets();
+    return Stats;
+}
+
 bool Socket::IsActive() const {
     return m_IsActive;
 }
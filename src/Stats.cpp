@@ -0,0 +1,120 @@
+#include "drowsynetwork/Stats.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace DrowsyNetwork {
+
+ServerStats ServerCounters::Snapshot() const {
+    std::array<uint64_t, CounterCount> Totals{};
+    for (const auto& Entry : m_Slots) {
+        for (size_t Index = 0; Index < CounterCount; ++Index) {
+            Totals[Index] += Entry.Values[Index].load(std::memory_order_relaxed);
+        }
+    }
+
+    ServerStats Stats;
+    Stats.Time = StatsClock::now();
+    Stats.Accepted = Totals[Accepted];
+    Stats.AcceptErrors = Totals[AcceptErrors];
+    Stats.SocketsOpened = Totals[SocketsOpened];
+    Stats.SocketsClosed = Totals[SocketsClosed];
+    Stats.BytesReceived = Totals[BytesReceived];
+    Stats.BytesSent = Totals[BytesSent];
+    Stats.PacketsSent = Totals[PacketsSent];
+    Stats.Reads = Totals[Reads];
+    Stats.Writes = Totals[Writes];
+    Stats.PendingWriteBytes = Totals[PendingWriteBytes];
+    Stats.PendingWritePackets = Totals[PendingWritePackets];
+    return Stats;
+}
+
+void ServerCounters::RecordAcceptError(const std::error_code& ErrorCode) {
+    Add(AcceptErrors, 1);
+
+    std::lock_guard<std::mutex> Lock(m_AcceptErrorMutex);
+    auto It = std::ranges::find_if(m_AcceptErrors, [&](const AcceptErrorCount& Entry) {
+        return Entry.Code == ErrorCode.value() && Entry.Category == ErrorCode.category().name();
+    });
+    if (It == m_AcceptErrors.end()) {
+        It = m_AcceptErrors.insert(m_AcceptErrors.end(), AcceptErrorCount{ ErrorCode.category().name(), ErrorCode.value(), ErrorCode.message(), 0 });
+    }
+
+    ++It->Count;
+}
+
+std::vector<AcceptErrorCount> ServerCounters::GetAcceptErrors() const {
+    std::lock_guard<std::mutex> Lock(m_AcceptErrorMutex);
+    return m_AcceptErrors;
+}
+
+size_t GetStatsThreadSlot() {
+    static std::atomic<size_t> s_NextSlot(0);
+    thread_local const size_t t_Slot = s_NextSlot.fetch_add(1, std::memory_order_relaxed) % StatsSlotCount;
+    return t_Slot;
+}
+
+size_t HistogramSnapshot::GetBucket(uint64_t ValueNs) {
+    if (ValueNs < SubBuckets)
+        return ValueNs;
+
+    // Top bits of the value pick the power of two, the next 3 bits the sub-bucket
+    const auto Exponent = static_cast<size_t>(std::bit_width(ValueNs)) - 1;
+    const auto SubBucket = static_cast<size_t>(ValueNs >> (Exponent - SubBucketBits)) & (SubBuckets - 1);
+    return std::min((Exponent - SubBucketBits + 1) * SubBuckets + SubBucket, BucketCount - 1);
+}
+
+uint64_t HistogramSnapshot::GetBucketUpperBound(size_t Bucket) {
+    if (Bucket < SubBuckets)
+        return Bucket;
+
+    const auto Shift = Bucket / SubBuckets - 1;
+    const auto Lower = static_cast<uint64_t>(SubBuckets + Bucket % SubBuckets) << Shift;
+    return Lower + (uint64_t(1) << Shift) - 1;
+}
+
+uint64_t HistogramSnapshot::GetPercentileNs(double Percentile) const {
+    if (!Count)
+        return 0;
+
+    const auto Rank = static_cast<uint64_t>(std::ceil(std::clamp(Percentile, 0.0, 100.0) / 100.0 * Count));
+
+    uint64_t Seen = 0;
+    for (size_t Bucket = 0; Bucket < BucketCount; ++Bucket) {
+        Seen += Buckets[Bucket];
+        if (Seen >= std::max<uint64_t>(Rank, 1))
+            return std::min(GetBucketUpperBound(Bucket), MaxNs);
+    }
+
+    return MaxNs;
+}
+
+void LatencyHistogram::Record(StatsClock::duration Duration) {
+    const auto Nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Duration).count();
+    const auto Value = static_cast<uint64_t>(std::max<int64_t>(Nanoseconds, 0));
+
+    auto& Target = m_Slots[GetStatsThreadSlot()];
+    Target.Buckets[HistogramSnapshot::GetBucket(Value)].fetch_add(1, std::memory_order_relaxed);
+    Target.Count.fetch_add(1, std::memory_order_relaxed);
+    Target.SumNs.fetch_add(Value, std::memory_order_relaxed);
+
+    auto Max = Target.MaxNs.load(std::memory_order_relaxed);
+    while (Value > Max && !Target.MaxNs.compare_exchange_weak(Max, Value, std::memory_order_relaxed)) {}
+}
+
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+    HistogramSnapshot Result;
+    for (const auto& Entry : m_Slots) {
+        for (size_t Bucket = 0; Bucket < HistogramSnapshot::BucketCount; ++Bucket) {
+            Result.Buckets[Bucket] += Entry.Buckets[Bucket].load(std::memory_order_relaxed);
+        }
+
+        Result.Count += Entry.Count.load(std::memory_order_relaxed);
+        Result.SumNs += Entry.SumNs.load(std::memory_order_relaxed);
+        Result.MaxNs = std::max(Result.MaxNs, Entry.MaxNs.load(std::memory_order_relaxed));
+    }
+
+    return Result;
+}
+
+} // namespace DrowsyNetwork
@@ -0,0 +1,153 @@
+#include <drowsynetwork/Server.hpp>
+#include <drowsynetwork/Socket.hpp>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <print>
+#include <thread>
+
+/**
+ * @file echo_allocations.cpp
+ * @brief Checks that an echo round trip doesn't touch the heap
+ *
+ * Every operator new in the process is counted. A client echoes messages
+ * through a loopback Socket; after a warm-up (which sizes the write lanes,
+ * fills the packet pool and sets up the handler memory) the measured round
+ * trips must not allocate at all.
+ */
+
+namespace {
+
+std::atomic<uint64_t> g_Allocations{0};
+
+}
+
+void* operator new(std::size_t Size) {
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* Pointer = std::malloc(Size ? Size : 1))
+        return Pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* Pointer) noexcept { std::free(Pointer); }
+void operator delete(void* Pointer, std::size_t) noexcept { std::free(Pointer); }
+
+namespace {
+
+using namespace DrowsyNetwork;
+
+constexpr size_t MessageSize = 32;
+constexpr int WarmupRoundTrips = 1000;
+constexpr int MeasuredRoundTrips = 10000;
+
+/// Fixed-size packet, so creating one only touches the PacketPool
+class EchoMessage {
+public:
+    EchoMessage(const uint8_t* Data, size_t Size) : m_Size(std::min(Size, m_Bytes.size())) {
+        std::memcpy(m_Bytes.data(), Data, m_Size);
+    }
+
+    [[nodiscard]] size_t GetSize() const { return m_Size; }
+    [[nodiscard]] const uint8_t* GetBufferPointer() const { return m_Bytes.data(); }
+
+private:
+    std::array<uint8_t, MessageSize> m_Bytes;
+    size_t m_Size;
+};
+
+class EchoSocket : public Socket {
+public:
+    using Socket::Socket;
+
+protected:
+    void OnRead(const uint8_t* Data, size_t Size) override {
+        Send(PacketBase<EchoMessage>::Create(Data, Size));
+    }
+
+    void OnDisconnect() override {}
+};
+
+class EchoServer : public Server {
+public:
+    using Server::Server;
+
+    ~EchoServer() override { Stop(); }
+
+    uint16_t ListenOnLoopback() {
+        if (!Bind(TcpEndpoint(asio::ip::address_v4::loopback(), 0)))
+            return 0;
+
+        StartListening();
+        return GetAcceptor(0)->local_endpoint().port();
+    }
+
+    std::shared_ptr<EchoSocket> m_Connection;
+
+protected:
+    void OnAccept(std::unique_ptr<TcpSocket>&& Socket) override {
+        Socket->set_option(asio::ip::tcp::no_delay(true));
+        m_Connection = std::make_shared<EchoSocket>(m_IoContext, std::move(Socket));
+        m_Connection->Setup(m_Counters);
+    }
+};
+
+} // namespace
+
+int main() {
+    SetLogLevel(LogLevel::Off);
+
+    Executor Context(1);
+    auto WorkGuard = asio::make_work_guard(Context);
+    EchoServer Echo(Context);
+    const auto Port = Echo.ListenOnLoopback();
+    if (!Port) {
+        std::println("failed to listen");
+        return 1;
+    }
+
+    std::thread Runner([&Context] { Context.run(); });
+
+    asio::io_context ClientContext;
+    asio::ip::tcp::socket Client(ClientContext);
+    Client.connect(TcpEndpoint(asio::ip::address_v4::loopback(), Port));
+    Client.set_option(asio::ip::tcp::no_delay(true));
+
+    std::array<uint8_t, MessageSize> Request{};
+    std::array<uint8_t, MessageSize> Reply{};
+    const auto RoundTrip = [&](int Index) {
+        std::memcpy(Request.data(), &Index, sizeof(Index));
+        asio::write(Client, asio::buffer(Request));
+        asio::read(Client, asio::buffer(Reply));
+        return Reply == Request;
+    };
+
+    for (int Index = 0; Index < WarmupRoundTrips; ++Index) {
+        if (!RoundTrip(Index)) {
+            std::println("echo mismatch during warm-up");
+            return 1;
+        }
+    }
+
+    const auto Before = g_Allocations.load(std::memory_order_relaxed);
+    bool Matched = true;
+    for (int Index = 0; Index < MeasuredRoundTrips; ++Index) {
+        Matched &= RoundTrip(Index);
+    }
+    const auto Allocations = g_Allocations.load(std::memory_order_relaxed) - Before;
+
+    Client.close();
+    WorkGuard.reset();
+    Context.stop();
+    Runner.join();
+
+    std::println("{} allocations over {} round trips", Allocations, MeasuredRoundTrips);
+    if (!Matched) {
+        std::println("echo mismatch");
+        return 1;
+    }
+
+    return Allocations == 0 ? 0 : 1;
+}